@@ -111,6 +111,7 @@ namespace snmalloc
 #ifdef SNMALLOC_TRACING
       message<1024>("Alloc chunk: {} ({})", p.unsafe_ptr(), size);
 #endif
+      EventLog::record(LogEvent::AllocChunk, address_cast(p), size);
       if (p == nullptr)
       {
         local_state.get_meta_range().dealloc_range(meta_cap, SizeofMetadata);
@@ -118,11 +119,13 @@ namespace snmalloc
 #ifdef SNMALLOC_TRACING
         message<1024>("Out of memory");
 #endif
+        EventLog::record(LogEvent::OutOfMemory, 0, size);
         return {nullptr, nullptr};
       }
 
       typename Pagemap::Entry t(meta, ras);
       Pagemap::set_metaentry(address_cast(p), size, t);
+      OverheadStats::add_slab_metadata(SizeofMetadata);
 
       return {Aal::capptr_bound<void, capptr::bounds::Chunk>(p, size), meta};
     }
@@ -169,10 +172,20 @@ namespace snmalloc
 
       local_state.get_meta_range().dealloc_range(
         capptr::Arena<void>::unsafe_from(&slab_metadata), SizeofMetadata);
+      OverheadStats::remove_slab_metadata(SizeofMetadata);
 
       local_state.get_object_range()->dealloc_range(arena, size);
     }
 
+    /**
+     * Return the memory cached by `local_state` to the global ranges, so that
+     * other allocators can use it and the committed usage drops.
+     */
+    static void purge(LocalState& local_state)
+    {
+      local_state.purge();
+    }
+
     template<bool potentially_out_of_range = false>
     SNMALLOC_FAST_PATH static const PagemapEntry& get_metaentry(address_t p)
     {
@@ -15,7 +15,28 @@ namespace snmalloc
     // Size of requests that the global cache should use
     static constexpr size_t GlobalCacheSizeBits = 24;
 
+    // Maximum size of requests that the global cache grows to as the heap
+    // grows beyond GlobalCacheSizeBits.
+    static constexpr size_t GlobalCacheMaxSizeBits =
+#ifdef SNMALLOC_GLOBAL_CACHE_MAX_SIZE_BITS
+      SNMALLOC_GLOBAL_CACHE_MAX_SIZE_BITS
+#else
+      (bits::BITS == 64) ? 30 : GlobalCacheSizeBits
+#endif
+      ;
+
     // Size of requests that the local cache should use
     static constexpr size_t LocalCacheSizeBits = 21;
+
+    // Maximum size of requests that the local cache grows to as an
+    // allocator's use of large objects grows beyond LocalCacheSizeBits.  This
+    // also bounds the memory that the local cache holds.
+    static constexpr size_t LocalCacheMaxSizeBits =
+#ifdef SNMALLOC_LOCAL_CACHE_MAX_SIZE_BITS
+      SNMALLOC_LOCAL_CACHE_MAX_SIZE_BITS
+#else
+      (bits::BITS == 64) ? 23 : LocalCacheSizeBits
+#endif
+      ;
   };
 } // namespace snmalloc
\ No newline at end of file
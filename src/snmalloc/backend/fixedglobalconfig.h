@@ -6,15 +6,30 @@
 namespace snmalloc
 {
   /**
-   * A single fixed address range allocator configuration
+   * A single fixed address range allocator configuration.
+   *
+   * Configurations that manage a fixed range differently can derive from
+   * this one, passing themselves as `Derived`, so that the allocator pool is
+   * for the derived configuration.
+   *
+   * If `Shards` is more than one, the range is split between that many
+   * global ranges, so that threads allocating concurrently mostly take
+   * different locks.  This limits the size of the largest object to the
+   * heap's size divided by `Shards`, rounded down to a power of two.
    */
-  template<SNMALLOC_CONCEPT(IsPAL) PAL>
-  class FixedRangeConfig final : public CommonConfig
+  template<
+    SNMALLOC_CONCEPT(IsPAL) PAL,
+    typename Derived = void,
+    size_t Shards = 1>
+  class FixedRangeConfig : public CommonConfig
   {
+    using Self =
+      std::conditional_t<std::is_void_v<Derived>, FixedRangeConfig, Derived>;
+
   public:
     using PagemapEntry = DefaultPagemapEntry;
 
-  private:
+  protected:
     using ConcretePagemap =
       FlatPagemap<MIN_CHUNK_BITS, PagemapEntry, PAL, true>;
 
@@ -33,15 +48,22 @@ namespace snmalloc
     };
 
   public:
-    using LocalState = StandardLocalState<PAL, Pagemap>;
+    using LocalState = StandardLocalState<
+      PAL,
+      Pagemap,
+      EmptyRange<>,
+      MinBaseSizeBits<PAL>(),
+      true,
+      Shards>;
 
-    using GlobalPoolState = PoolState<CoreAllocator<FixedRangeConfig>>;
+    using GlobalPoolState = PoolState<CoreAllocator<Self>>;
 
     using Backend =
       BackendAllocator<PAL, PagemapEntry, Pagemap, Authmap, LocalState>;
     using Pal = PAL;
 
   private:
+    SNMALLOC_REQUIRE_CONSTINIT
     inline static GlobalPoolState alloc_pool;
 
   public:
@@ -91,6 +113,11 @@ namespace snmalloc
         LocalState::set_small_heap();
       }
 
+      if constexpr (Shards > 1)
+      {
+        LocalState::set_heap_size(heap_length);
+      }
+
       Authmap::arena = capptr::Arena<void>::unsafe_from(heap_base);
 
       Pagemap::register_range(Authmap::arena, heap_length);
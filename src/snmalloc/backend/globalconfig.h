@@ -91,7 +91,7 @@ namespace snmalloc
      * Used to prevent two threads attempting to initialise the configuration
      */
     SNMALLOC_REQUIRE_CONSTINIT
-    inline static FlagWord initialisation_lock{};
+    inline static FlagWord initialisation_lock{"initialisation"};
 
     // Performs initialisation for this configuration
     // of allocators.
@@ -118,6 +118,9 @@ namespace snmalloc
 
       Pagemap::concretePagemap.template init<pagemap_randomize>();
 
+      // Scale caching to the memory available to the process.
+      MemoryBudget::refresh<Pal>();
+
       if constexpr (aal_supports<StrictProvenance>)
       {
         Authmap::init();
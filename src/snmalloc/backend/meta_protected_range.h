@@ -20,15 +20,25 @@ namespace snmalloc
    * On Windows this 16 as VirtualAlloc cannot reserve less than 64KiB.
    * Alternative configurations might make this 2MiB so that huge pages
    * can be used.
+   *
+   * IsThreadSafe is false for configurations used by a single thread, which
+   * need not lock the global ranges.  Their memory is then not counted
+   * towards the `HeapLimit`, which would need atomic updates.
    */
   template<
     typename PAL,
     typename Pagemap,
     typename Base,
-    size_t MinSizeBits = MinBaseSizeBits<PAL>()>
+    size_t MinSizeBits = MinBaseSizeBits<PAL>(),
+    bool IsThreadSafe = true>
   struct MetaProtectedRangeLocalState : BaseLocalStateConstants
   {
   private:
+    using GlobalRangeT = std::
+      conditional_t<IsThreadSafe, GlobalRange, SingleThreadGlobalRange>;
+
+    using StatsRangeT = BasicStatsRange<IsThreadSafe>;
+
     // Global range of memory
     using GlobalR = Pipe<
       Base,
@@ -36,9 +46,10 @@ namespace snmalloc
         GlobalCacheSizeBits,
         bits::BITS - 1,
         Pagemap,
-        MinSizeBits>,
+        MinSizeBits,
+        GlobalCacheMaxSizeBits>,
       LogRange<2>,
-      GlobalRange>;
+      GlobalRangeT>;
 
     static constexpr size_t page_size_bits =
       bits::next_pow2_bits_const(PAL::page_size);
@@ -53,9 +64,9 @@ namespace snmalloc
       GlobalR,
       LargeBuddyRange<GlobalCacheSizeBits, bits::BITS - 1, Pagemap>,
       LogRange<3>,
-      GlobalRange,
+      GlobalRangeT,
       CommitRange<PAL>,
-      StatsRange>;
+      StatsRangeT>;
 
     // Controls the padding around the meta-data range.
     // The larger the padding range the more randomisation that
@@ -81,18 +92,20 @@ namespace snmalloc
         Pagemap,
         page_size_bits>,
       LogRange<4>,
-      GlobalRange,
-      StatsRange>;
+      GlobalRangeT,
+      StatsRangeT>;
 
     // Local caching of object range
-    using ObjectRange = Pipe<
+    using LocalObjectCache = Pipe<
       CentralObjectRange,
       LargeBuddyRange<
         LocalCacheSizeBits,
-        LocalCacheSizeBits,
+        LocalCacheMaxSizeBits,
         Pagemap,
-        page_size_bits>,
-      LogRange<5>>;
+        page_size_bits,
+        LocalCacheMaxSizeBits>>;
+
+    using ObjectRange = Pipe<LocalObjectCache, LogRange<5>>;
 
     // Local caching of meta-data range
     using MetaRange = Pipe<
@@ -120,10 +133,19 @@ namespace snmalloc
       return meta_range;
     }
 
+    /**
+     * Return the memory cached for objects by this local state to the
+     * central object range.
+     */
+    void purge()
+    {
+      object_range.template ancestor<LocalObjectCache>()->purge();
+    }
+
     // Create global range that can service small meta-data requests.
     // Don't want to add the SmallBuddyRange to the CentralMetaRange as that
     // would require committing memory inside the main global lock.
     using GlobalMetaRange =
-      Pipe<CentralMetaRange, SmallBuddyRange, GlobalRange>;
+      Pipe<CentralMetaRange, SmallBuddyRange, GlobalRangeT>;
   };
 } // namespace snmalloc
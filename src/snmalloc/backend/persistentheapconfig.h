@@ -0,0 +1,304 @@
+#pragma once
+
+#include "../backend_helpers/backend_helpers.h"
+#include "sharedheapconfig.h"
+
+namespace snmalloc
+{
+  /**
+   * A heap in a region of memory that outlives the process, such as a file
+   * mapped with `MAP_SHARED`.  A later process that maps the region at the
+   * same address can reopen the heap and continue to use every object that
+   * was allocated in it.
+   *
+   * The region starts with a header holding the global range, the pool of
+   * allocators, a root pointer from which the program can find its objects,
+   * and a flag recording whether the heap was closed cleanly.  The pagemap
+   * and the allocators follow in the region, so the allocators, with the
+   * slabs and chunks that they cache, are reused by the threads of the next
+   * process.
+   *
+   * A heap is used by one process at a time, which calls `create` or `open`
+   * before allocating, and `close` once all of its allocators have been torn
+   * down.  When a heap is reopened, allocators that were left in use, for
+   * instance by threads that exited without tearing down, are flushed and
+   * returned to the pool, and the memory cached by the pooled allocators is
+   * returned to the global range.  Objects that were held in the thread
+   * caches of such allocators are lost.  If the process stopped part way
+   * through an operation on the heap, the heap may be inconsistent, so a
+   * caller that cannot tolerate this should discard a heap for which
+   * `was_clean` is false.
+   *
+   * The heap must be reopened by the same build of the program.  Writing the
+   * region back to its file, for instance with `msync`, is left to the
+   * caller.  Usage statistics and the `HeapLimit` count only the memory
+   * taken and returned by this process, so do not account for a reopened
+   * heap.
+   */
+  template<SNMALLOC_CONCEPT(IsPAL) PAL>
+  class PersistentHeapConfig final : public CommonConfig
+  {
+    // As for `SharedHeapConfig`, the region is a shared mapping of a file,
+    // whose pages are not zeroed by being discarded.
+    static_assert(
+      pal_supports<NoAllocation, PAL>,
+      "The persistent heap needs a PAL that zeroes memory by writing to it");
+
+  public:
+    using PagemapEntry = DefaultPagemapEntry;
+
+  private:
+    using ConcretePagemap =
+      FlatPagemap<MIN_CHUNK_BITS, PagemapEntry, PAL, true>;
+
+    using Pagemap = BasicPagemap<PAL, ConcretePagemap, PagemapEntry, true>;
+
+    struct Authmap
+    {
+      static inline capptr::Arena<void> arena;
+
+      template<bool potentially_out_of_range = false>
+      static SNMALLOC_FAST_PATH capptr::Arena<void>
+      amplify(capptr::Alloc<void> c)
+      {
+        return Aal::capptr_rebound(arena, c);
+      }
+    };
+
+  public:
+    using LocalState = SharedHeapLocalState<PAL, Pagemap>;
+
+    using GlobalPoolState = PoolState<CoreAllocator<PersistentHeapConfig>>;
+
+    using Backend =
+      BackendAllocator<PAL, PagemapEntry, Pagemap, Authmap, LocalState>;
+    using Pal = PAL;
+
+  private:
+    using SharedRange = typename LocalState::SharedRange;
+
+    /**
+     * The state at the start of the region that persists between processes.
+     */
+    struct Header
+    {
+      /// Set to `MAGIC` once the heap has been created.
+      std::atomic<uint64_t> magic;
+
+      /// The address and length of the region when it was created.  The
+      /// pointers in the heap are only valid at this address.
+      void* base;
+      size_t length;
+
+      /// Set by `close`, and cleared when the heap is opened.
+      std::atomic<bool> clean;
+
+      std::atomic<void*> root;
+
+      /// The key for messages sent between allocators.
+      FreeListKey key;
+
+      SharedRange range;
+
+      GlobalPoolState pool;
+    };
+
+    static constexpr uint64_t MAGIC = 0x736e6d616c706572;
+
+    static constexpr size_t HEADER_SIZE =
+      bits::align_up(sizeof(Header), PAL::page_size);
+
+    inline static Header* header{nullptr};
+
+    /**
+     * Whether the heap had been closed when this process opened it.
+     */
+    inline static bool opened_clean{false};
+
+    /**
+     * Set up the state of this process for the region, and return the part
+     * of it used for the heap.
+     */
+    static std::pair<void*, size_t> setup(void* base, size_t length)
+    {
+      header = static_cast<Header*>(base);
+      LocalState::set_shared_range(&header->range);
+      RemoteAllocator::key_global = header->key;
+
+      auto [heap_base, heap_length] = Pagemap::concretePagemap.init(
+        pointer_offset(base, HEADER_SIZE), length - HEADER_SIZE);
+
+      if (length < MIN_HEAP_SIZE_FOR_THREAD_LOCAL_BUDDY)
+      {
+        LocalState::set_small_heap();
+      }
+
+      Authmap::arena = capptr::Arena<void>::unsafe_from(heap_base);
+
+      Pagemap::register_range(Authmap::arena, heap_length);
+
+      return {heap_base, heap_length};
+    }
+
+    /**
+     * Return to the pool the allocators that the previous process left in
+     * use, and return the memory cached by the pool to the global range.
+     */
+    static void recover()
+    {
+      using Pool = AllocPool<PersistentHeapConfig>;
+
+      for (auto* alloc = Pool::iterate(); alloc != nullptr;
+           alloc = Pool::iterate(alloc))
+      {
+        if (alloc->debug_is_in_use())
+        {
+          // Attach a new cache, which flushing the allocator detaches
+          // again before releasing it to the pool.
+          LocalAllocator<PersistentHeapConfig> local;
+          local.init(alloc);
+          local.flush();
+        }
+      }
+
+      AllocPoolPurge<PersistentHeapConfig>::purge_unused();
+    }
+
+  public:
+    /**
+     * Provides the state to create new allocators, which is in the region,
+     * so is only valid once the heap has been created or opened.
+     */
+    static GlobalPoolState& pool()
+    {
+      return header->pool;
+    }
+
+    static constexpr Flags Options = []() constexpr {
+      Flags opts = {};
+      opts.HasDomesticate = true;
+      return opts;
+    }();
+
+    static void register_clean_up()
+    {
+      snmalloc::register_clean_up();
+    }
+
+    /**
+     * Create a heap in the region of `length` bytes at `base`, which must be
+     * zeroed, as a newly extended file is.
+     */
+    static void create(void* base, size_t length)
+    {
+      if (length <= HEADER_SIZE)
+        PAL::error("Persistent heap region is too small.");
+
+      auto h = new (base) Header{
+        0, base, length, false, nullptr, RemoteAllocator::key_global, {}, {}};
+
+      auto [heap_base, heap_length] = setup(base, length);
+
+      // Push memory into the global range.
+      range_to_pow_2_blocks<MIN_CHUNK_BITS>(
+        capptr::Arena<void>::unsafe_from(heap_base),
+        heap_length,
+        [&](capptr::Arena<void> p, size_t sz, bool) {
+          h->range.dealloc_range(p, sz);
+        });
+
+      opened_clean = true;
+      h->magic.store(MAGIC, std::memory_order_release);
+    }
+
+    /**
+     * Reopen the heap in the region of `length` bytes at `base`.  Returns
+     * false if there is no heap there, or it was created at a different
+     * address or size.
+     *
+     * This replaces the process's `RemoteAllocator::key_global`, so should
+     * be called before any other snmalloc configuration is used.
+     */
+    static bool open(void* base, size_t length)
+    {
+      auto h = static_cast<Header*>(base);
+      if (
+        (length <= HEADER_SIZE) ||
+        (h->magic.load(std::memory_order_acquire) != MAGIC) ||
+        (h->base != base) || (h->length != length))
+        return false;
+
+      setup(base, length);
+      opened_clean = h->clean.exchange(false, std::memory_order_acq_rel);
+      recover();
+      return true;
+    }
+
+    /**
+     * Mark the heap as closed cleanly.  Every allocator for the heap must
+     * have been torn down, and the heap must not be used again by this
+     * process.
+     */
+    static void close()
+    {
+      for (auto* alloc = AllocPool<PersistentHeapConfig>::iterate();
+           alloc != nullptr;
+           alloc = AllocPool<PersistentHeapConfig>::iterate(alloc))
+      {
+        if (alloc->debug_is_in_use())
+          PAL::error("Persistent heap closed with an allocator in use.");
+      }
+
+      header->clean.store(true, std::memory_order_release);
+    }
+
+    /**
+     * Returns true if the heap was newly created, or had been closed by the
+     * process that used it last.
+     */
+    static bool was_clean()
+    {
+      return opened_clean;
+    }
+
+    /**
+     * The root pointer, from which the program finds its objects when the
+     * heap is reopened.
+     */
+    static void* get_root()
+    {
+      return header->root.load(std::memory_order_acquire);
+    }
+
+    static void set_root(void* p)
+    {
+      header->root.store(p, std::memory_order_release);
+    }
+
+    /* Verify that a pointer points into the region managed by this config */
+    template<typename T, SNMALLOC_CONCEPT(capptr::IsBound) B>
+    static SNMALLOC_FAST_PATH CapPtr<
+      T,
+      typename B::template with_wildness<capptr::dimension::Wildness::Tame>>
+    capptr_domesticate(LocalState* ls, CapPtr<T, B> p)
+    {
+      static_assert(B::wildness == capptr::dimension::Wildness::Wild);
+
+      static const size_t sz = sizeof(
+        std::conditional<std::is_same_v<std::remove_cv<T>, void>, void*, T>);
+
+      UNUSED(ls);
+      auto address = address_cast(p);
+      auto [base, length] = Pagemap::get_bounds();
+      if ((address - base > (length - sz)) || (length < sz))
+      {
+        return nullptr;
+      }
+
+      return CapPtr<
+        T,
+        typename B::template with_wildness<capptr::dimension::Wildness::Tame>>::
+        unsafe_from(p.unsafe_ptr());
+    }
+  };
+} // namespace snmalloc
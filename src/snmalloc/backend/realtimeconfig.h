@@ -0,0 +1,85 @@
+#pragma once
+
+#include "fixedglobalconfig.h"
+
+namespace snmalloc
+{
+  /**
+   * The Pal used by `RealTimeConfig` once the heap has been set up.  Its
+   * memory management operations are no-ops, but the time and entropy
+   * sources, and pinning, of the underlying Pal are still available.
+   */
+  template<SNMALLOC_CONCEPT(IsPAL) BasePAL>
+  struct RealTimePal : public PALNoAlloc<BasePAL>
+  {
+    static constexpr uint64_t pal_features =
+      PALNoAlloc<BasePAL>::pal_features |
+      (BasePAL::pal_features & (Entropy | Time | PinMemory));
+  };
+
+  /**
+   * A configuration for latency-critical processes.
+   *
+   * A fixed budget of memory is reserved from the platform by `init`,
+   * faulted in, optionally pinned, and then used as the entire heap.  After
+   * that, the allocator never calls into the platform to manage memory: the
+   * heap is never grown with `mmap`, freed memory is never decommitted, and
+   * zeroing uses `memset`.  When the budget is exhausted allocation fails
+   * immediately with `ENOMEM`.
+   *
+   * Other than how the range is obtained, this is `FixedRangeConfig`.  The
+   * `CommitRange` in its standard range configuration uses `RealTimePal`, so
+   * never returns memory to the platform.
+   */
+  template<SNMALLOC_CONCEPT(IsPAL) BasePAL = DefaultPal>
+  class RealTimeConfig final
+  : public FixedRangeConfig<RealTimePal<BasePAL>, RealTimeConfig<BasePAL>>
+  {
+    using Base =
+      FixedRangeConfig<RealTimePal<BasePAL>, RealTimeConfig<BasePAL>>;
+
+    /**
+     * Specifies if the heap has been set up by `init`.
+     */
+    SNMALLOC_REQUIRE_CONSTINIT
+    inline static std::atomic<bool> initialised{false};
+
+  public:
+    using Pal = typename Base::Pal;
+
+    static bool is_initialised()
+    {
+      return initialised;
+    }
+
+    /**
+     * Reserve `budget` bytes from the platform, fault them in, and use them
+     * as the heap.  If `pin` is set, the memory is also pinned so that it
+     * cannot be paged out.  This must be called once, before any allocation.
+     *
+     * Returns false if pinning was requested and failed.  The heap is still
+     * usable in this case, but may be paged out.
+     */
+    static bool init(size_t budget, bool pin = false)
+    {
+      SNMALLOC_CHECK(!initialised);
+
+      void* base = BasePAL::reserve(budget);
+      if (base == nullptr)
+        BasePAL::error("Failed to reserve real-time heap.");
+      BasePAL::template notify_using<NoZero>(base, budget);
+
+      bool result = pal_prefault<Pal>(base, budget, pin);
+
+      LocalEntropy entropy;
+      entropy.init<Pal>();
+      // Initialise key for remote deallocation lists
+      RemoteAllocator::key_global = FreeListKey(entropy.get_free_list_key());
+
+      Base::init(nullptr, base, budget);
+
+      initialised.store(true, std::memory_order_release);
+      return result;
+    }
+  };
+} // namespace snmalloc
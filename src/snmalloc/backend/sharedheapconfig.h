@@ -0,0 +1,291 @@
+#pragma once
+
+#include "../backend_helpers/backend_helpers.h"
+#include "base_constants.h"
+
+namespace snmalloc
+{
+  /**
+   * Ranges for a heap in a region of memory that is shared by several
+   * processes.  The global range is kept in the region itself, so that all
+   * of the processes allocate from it, and is protected by a lock that is
+   * also in the region.  Everything else is private to each process, and
+   * caches only memory that the process has taken from the global range.
+   */
+  template<typename PAL, typename Pagemap>
+  struct SharedHeapLocalState : BaseLocalStateConstants
+  {
+    /**
+     * The range shared by all of the processes, placed in the region.
+     */
+    using SharedRange = Pipe<
+      EmptyRange<>,
+      LargeBuddyRange<
+        GlobalCacheSizeBits,
+        bits::BITS - 1,
+        Pagemap,
+        MIN_CHUNK_BITS,
+        GlobalCacheMaxSizeBits>,
+      SharedLockRange>;
+
+    // Each process reaches the shared range through a pointer.
+    using GlobalR = Pipe<SharedRange, IndirectRange, StaticRange>;
+
+    // Track stats of the committed memory
+    using Stats = Pipe<GlobalR, CommitRange<PAL>, StatsRange>;
+
+  private:
+    static constexpr size_t page_size_bits =
+      bits::next_pow2_bits_const(PAL::page_size);
+
+  public:
+    using LargeObjectRange = Pipe<
+      Stats,
+      StaticConditionalRange<LargeBuddyRange<
+        LocalCacheSizeBits,
+        LocalCacheMaxSizeBits,
+        Pagemap,
+        page_size_bits,
+        LocalCacheMaxSizeBits>>>;
+
+  private:
+    using ObjectRange = Pipe<LargeObjectRange, SmallBuddyRange>;
+
+    ObjectRange object_range;
+
+  public:
+    // Expose a global range for the initial allocation of meta-data.
+    using GlobalMetaRange = Pipe<ObjectRange, GlobalRange>;
+
+    LargeObjectRange* get_object_range()
+    {
+      return object_range.template ancestor<LargeObjectRange>();
+    }
+
+    ObjectRange& get_meta_range()
+    {
+      return object_range;
+    }
+
+    void purge()
+    {
+      get_object_range()->purge();
+    }
+
+    static void set_small_heap()
+    {
+      // This disables the thread local caching of large objects.
+      LargeObjectRange::disable_range();
+    }
+
+    /**
+     * Direct this process's allocations to the shared range `range`.
+     */
+    static void set_shared_range(SharedRange* range)
+    {
+      GlobalR g;
+      g.template ancestor<typename IndirectRange::template Type<SharedRange>>()
+        ->set_parent(range);
+    }
+  };
+
+  /**
+   * A heap in a region of memory that is mapped at the same address in
+   * several processes, such as a `MAP_SHARED` mapping made before `fork`, or
+   * a `memfd` mapped at a fixed address.  Objects allocated by one process
+   * can be passed to, and freed by, any of the others.
+   *
+   * The region starts with a header holding the global range and its lock,
+   * followed by the pagemap and then the heap.  The allocators, and their
+   * message queues, are allocated from the region, so a process frees
+   * another's objects by sending them to the owning allocator, as between
+   * threads.  The owner must keep running, and allocating or flushing, to
+   * reuse the memory.
+   *
+   * One process calls `create` and the others `attach`, before allocating.
+   * A process that has allocated from the region must not `fork`, as the
+   * child would inherit the parent's allocators and caches.  A child forked
+   * after `create` but before any allocation needs no `attach`.
+   *
+   * Usage statistics and the `HeapLimit` are per process.
+   */
+  template<SNMALLOC_CONCEPT(IsPAL) PAL>
+  class SharedHeapConfig final : public CommonConfig
+  {
+    // Memory returned to the heap is zeroed with `notify_using<YesZero>`.
+    // Most platforms do that by discarding the pages, which leaves the
+    // contents of a `MAP_SHARED` mapping in place, so the PAL must write
+    // the zeros, as `PALNoAlloc` does with `memset`.
+    static_assert(
+      pal_supports<NoAllocation, PAL>,
+      "The shared heap needs a PAL that zeroes memory by writing to it");
+
+  public:
+    using PagemapEntry = DefaultPagemapEntry;
+
+  private:
+    using ConcretePagemap =
+      FlatPagemap<MIN_CHUNK_BITS, PagemapEntry, PAL, true>;
+
+    using Pagemap = BasicPagemap<PAL, ConcretePagemap, PagemapEntry, true>;
+
+    struct Authmap
+    {
+      static inline capptr::Arena<void> arena;
+
+      template<bool potentially_out_of_range = false>
+      static SNMALLOC_FAST_PATH capptr::Arena<void>
+      amplify(capptr::Alloc<void> c)
+      {
+        return Aal::capptr_rebound(arena, c);
+      }
+    };
+
+  public:
+    using LocalState = SharedHeapLocalState<PAL, Pagemap>;
+
+    using GlobalPoolState = PoolState<CoreAllocator<SharedHeapConfig>>;
+
+    using Backend =
+      BackendAllocator<PAL, PagemapEntry, Pagemap, Authmap, LocalState>;
+    using Pal = PAL;
+
+  private:
+    using SharedRange = typename LocalState::SharedRange;
+
+    /**
+     * The state at the start of the region that is shared by the processes.
+     */
+    struct Header
+    {
+      /// Set to `MAGIC` once the region has been created.
+      std::atomic<uint64_t> magic;
+
+      /// The key for messages sent between allocators, which must be the
+      /// same in every process.
+      FreeListKey key;
+
+      SharedRange range;
+    };
+
+    static constexpr uint64_t MAGIC = 0x736e6d616c6c6f63;
+
+    static constexpr size_t HEADER_SIZE =
+      bits::align_up(sizeof(Header), PAL::page_size);
+
+    SNMALLOC_REQUIRE_CONSTINIT
+    inline static GlobalPoolState alloc_pool;
+
+    /**
+     * Set up the state of this process for the region, and return the part
+     * of it used for the heap.
+     */
+    static std::pair<void*, size_t> setup(void* base, size_t length)
+    {
+      auto header = static_cast<Header*>(base);
+      LocalState::set_shared_range(&header->range);
+      RemoteAllocator::key_global = header->key;
+
+      auto [heap_base, heap_length] = Pagemap::concretePagemap.init(
+        pointer_offset(base, HEADER_SIZE), length - HEADER_SIZE);
+
+      if (length < MIN_HEAP_SIZE_FOR_THREAD_LOCAL_BUDDY)
+      {
+        LocalState::set_small_heap();
+      }
+
+      Authmap::arena = capptr::Arena<void>::unsafe_from(heap_base);
+
+      Pagemap::register_range(Authmap::arena, heap_length);
+
+      return {heap_base, heap_length};
+    }
+
+  public:
+    static GlobalPoolState& pool()
+    {
+      return alloc_pool;
+    }
+
+    static constexpr Flags Options = []() constexpr {
+      Flags opts = {};
+      opts.HasDomesticate = true;
+      return opts;
+    }();
+
+    static void register_clean_up()
+    {
+      snmalloc::register_clean_up();
+    }
+
+    /**
+     * Create a heap in the region of `length` bytes at `base`, which must be
+     * zeroed.  The region's key for messages between allocators is this
+     * process's `RemoteAllocator::key_global`.
+     */
+    static void create(void* base, size_t length)
+    {
+      if (length <= HEADER_SIZE)
+        PAL::error("Shared heap region is too small.");
+
+      auto header = new (base) Header{0, RemoteAllocator::key_global, {}};
+
+      auto [heap_base, heap_length] = setup(base, length);
+
+      // Push memory into the shared range.
+      range_to_pow_2_blocks<MIN_CHUNK_BITS>(
+        capptr::Arena<void>::unsafe_from(heap_base),
+        heap_length,
+        [&](capptr::Arena<void> p, size_t sz, bool) {
+          header->range.dealloc_range(p, sz);
+        });
+
+      header->magic.store(MAGIC, std::memory_order_release);
+    }
+
+    /**
+     * Use the heap that another process has created in the region of
+     * `length` bytes at `base`.  Returns false if there is no heap there.
+     *
+     * This replaces the process's `RemoteAllocator::key_global`, so should
+     * be called before any other snmalloc configuration is used.
+     */
+    static bool attach(void* base, size_t length)
+    {
+      auto header = static_cast<Header*>(base);
+      if (
+        (length <= HEADER_SIZE) ||
+        (header->magic.load(std::memory_order_acquire) != MAGIC))
+        return false;
+
+      setup(base, length);
+      return true;
+    }
+
+    /* Verify that a pointer points into the region managed by this config */
+    template<typename T, SNMALLOC_CONCEPT(capptr::IsBound) B>
+    static SNMALLOC_FAST_PATH CapPtr<
+      T,
+      typename B::template with_wildness<capptr::dimension::Wildness::Tame>>
+    capptr_domesticate(LocalState* ls, CapPtr<T, B> p)
+    {
+      static_assert(B::wildness == capptr::dimension::Wildness::Wild);
+
+      static const size_t sz = sizeof(
+        std::conditional<std::is_same_v<std::remove_cv<T>, void>, void*, T>);
+
+      UNUSED(ls);
+      auto address = address_cast(p);
+      auto [base, length] = Pagemap::get_bounds();
+      if ((address - base > (length - sz)) || (length < sz))
+      {
+        return nullptr;
+      }
+
+      return CapPtr<
+        T,
+        typename B::template with_wildness<capptr::dimension::Wildness::Tame>>::
+        unsafe_from(p.unsafe_ptr());
+    }
+  };
+} // namespace snmalloc
@@ -0,0 +1,141 @@
+#pragma once
+
+#include "../backend_helpers/backend_helpers.h"
+#include "backend.h"
+#include "meta_protected_range.h"
+#include "standard_range.h"
+
+namespace snmalloc
+{
+  /**
+   * A configuration for programs that allocate from only one thread, such as
+   * single-threaded tools, or worker processes that each use one allocator.
+   *
+   * This is the `StandardConfig` without the cross-thread machinery that can
+   * be removed statically: allocators do not check their message queues on
+   * the slow paths, the global ranges are not locked, the usage statistics
+   * are kept in plain variables, and initialisation takes no lock.
+   * Deallocations of objects from another allocator on the same thread, for
+   * instance a `ScopedAllocator`, still work, but are only processed when the
+   * owning allocator is flushed.
+   *
+   * It is not free of atomic operations.  Sending deallocations between
+   * allocators uses the message queue, the allocator pool and the
+   * `MemoryPressure` epoch are shared with any other configuration, and the
+   * event counters, if enabled, can be read by other threads.  None of these
+   * is on the fast paths.  The memory used is not counted towards the
+   * `HeapLimit`, so `set_heap_limit` is not available.
+   *
+   * This shares the pagemap with `StandardConfig`, so it must be the only
+   * configuration in the program.  Define `SNMALLOC_PROVIDE_OWN_CONFIG` and
+   * declare `snmalloc::Alloc` as `LocalAllocator<SingleThreadConfig>` before
+   * including `snmalloc.h`.
+   */
+  class SingleThreadConfig final : public CommonConfig
+  {
+    using GlobalPoolState = PoolState<CoreAllocator<SingleThreadConfig>>;
+
+  public:
+    using Pal = DefaultPal;
+    using PagemapEntry = DefaultPagemapEntry;
+
+  private:
+    using ConcretePagemap =
+      FlatPagemap<MIN_CHUNK_BITS, PagemapEntry, Pal, false>;
+
+    using Pagemap = BasicPagemap<Pal, ConcretePagemap, PagemapEntry, false>;
+
+    using ConcreteAuthmap =
+      FlatPagemap<MinBaseSizeBits<Pal>(), capptr::Arena<void>, Pal, false>;
+
+    using Authmap = DefaultAuthmap<ConcreteAuthmap>;
+
+    using Base = Pipe<
+      PalRange<Pal>,
+      PagemapRegisterRange<Pagemap>,
+      PagemapRegisterRange<Authmap>>;
+
+  public:
+    /**
+     * The default range configurations, without locks.
+     */
+    using LocalState = std::conditional_t<
+      mitigations(metadata_protection),
+      MetaProtectedRangeLocalState<
+        Pal,
+        Pagemap,
+        Base,
+        MinBaseSizeBits<Pal>(),
+        false>,
+      StandardLocalState<Pal, Pagemap, Base, MinBaseSizeBits<Pal>(), false>>;
+
+    using Backend =
+      BackendAllocator<Pal, PagemapEntry, Pagemap, Authmap, LocalState>;
+
+  private:
+    SNMALLOC_REQUIRE_CONSTINIT
+    inline static GlobalPoolState alloc_pool;
+
+    /**
+     * Specifies if the Configuration has been initialised.
+     */
+    SNMALLOC_REQUIRE_CONSTINIT
+    inline static bool initialised{false};
+
+    SNMALLOC_SLOW_PATH static void ensure_init_slow()
+    {
+      LocalEntropy entropy;
+      entropy.init<Pal>();
+      // Initialise key for remote deallocation lists
+      RemoteAllocator::key_global = FreeListKey(entropy.get_free_list_key());
+
+      static constexpr bool pagemap_randomize =
+        mitigations(random_pagemap) && !aal_supports<StrictProvenance>;
+
+      Pagemap::concretePagemap.template init<pagemap_randomize>();
+
+      // Scale caching to the memory available to the process.
+      MemoryBudget::refresh<Pal>();
+
+      if constexpr (aal_supports<StrictProvenance>)
+      {
+        Authmap::init();
+      }
+
+      initialised = true;
+    }
+
+  public:
+    /**
+     * Provides the state to create new allocators.
+     */
+    static GlobalPoolState& pool()
+    {
+      return alloc_pool;
+    }
+
+    static constexpr Flags Options = []() constexpr {
+      Flags opts = {};
+      opts.IsSingleThreaded = true;
+      return opts;
+    }();
+
+    SNMALLOC_FAST_PATH static void ensure_init()
+    {
+      if (SNMALLOC_LIKELY(initialised))
+        return;
+
+      ensure_init_slow();
+    }
+
+    static bool is_initialised()
+    {
+      return initialised;
+    }
+
+    static void register_clean_up()
+    {
+      snmalloc::register_clean_up();
+    }
+  };
+} // namespace snmalloc
@@ -18,14 +18,40 @@ namespace snmalloc
    * On Windows this 16 as VirtualAlloc cannot reserve less than 64KiB.
    * Alternative configurations might make this 2MiB so that huge pages
    * can be used.
+   *
+   * IsThreadSafe is false for configurations used by a single thread, which
+   * need not lock the global ranges.  Their memory is then not counted
+   * towards the `HeapLimit`, which would need atomic updates.
+   *
+   * Shards is the number of global ranges the memory is split between, each
+   * with its own lock and its own stripes of the heap, as described by
+   * `ShardedRange`.  Each allocator takes memory from one of them, and from
+   * the others once that is exhausted.  If it is more than one,
+   * `set_heap_size` must be called before memory is added to the global
+   * range, and no object can be larger than a stripe.
    */
   template<
     typename PAL,
     typename Pagemap,
     typename Base = EmptyRange<>,
-    size_t MinSizeBits = MinBaseSizeBits<PAL>()>
+    size_t MinSizeBits = MinBaseSizeBits<PAL>(),
+    bool IsThreadSafe = true,
+    size_t Shards = 1>
   struct StandardLocalState : BaseLocalStateConstants
   {
+    static_assert(
+      IsThreadSafe || (Shards == 1),
+      "Sharding the global range is only useful with many threads");
+
+  private:
+    using GlobalRangeT = std::
+      conditional_t<IsThreadSafe, GlobalRange, SingleThreadGlobalRange>;
+
+    // The global range, split into shards if there are several.
+    using GlobalShardsT = std::
+      conditional_t<(Shards > 1), ShardedGlobalRange<Shards>, GlobalRangeT>;
+
+  public:
     // Global range of memory, expose this so can be filled by init.
     using GlobalR = Pipe<
       Base,
@@ -33,12 +59,14 @@ namespace snmalloc
         GlobalCacheSizeBits,
         bits::BITS - 1,
         Pagemap,
-        MinSizeBits>,
+        MinSizeBits,
+        GlobalCacheMaxSizeBits>,
       LogRange<2>,
-      GlobalRange>;
+      GlobalShardsT>;
 
     // Track stats of the committed memory
-    using Stats = Pipe<GlobalR, CommitRange<PAL>, StatsRange>;
+    using Stats =
+      Pipe<GlobalR, CommitRange<PAL>, BasicStatsRange<IsThreadSafe>>;
 
   private:
     static constexpr size_t page_size_bits =
@@ -51,9 +79,10 @@ namespace snmalloc
       Stats,
       StaticConditionalRange<LargeBuddyRange<
         LocalCacheSizeBits,
-        LocalCacheSizeBits,
+        LocalCacheMaxSizeBits,
         Pagemap,
-        page_size_bits>>>;
+        page_size_bits,
+        LocalCacheMaxSizeBits>>>;
 
   private:
     using ObjectRange = Pipe<LargeObjectRange, SmallBuddyRange>;
@@ -62,7 +91,7 @@ namespace snmalloc
 
   public:
     // Expose a global range for the initial allocation of meta-data.
-    using GlobalMetaRange = Pipe<ObjectRange, GlobalRange>;
+    using GlobalMetaRange = Pipe<ObjectRange, GlobalRangeT>;
 
     /**
      * Where we turn for allocations of user chunks.
@@ -86,10 +115,30 @@ namespace snmalloc
       return object_range;
     }
 
+    /**
+     * Return the memory cached for large objects by this local state to the
+     * global range.
+     */
+    void purge()
+    {
+      get_object_range()->purge();
+    }
+
     static void set_small_heap()
     {
       // This disables the thread local caching of large objects.
       LargeObjectRange::disable_range();
     }
+
+    /**
+     * Size the stripes of the global ranges for a heap of `length` bytes.
+     * This is available iff there is more than one shard.
+     */
+    template<size_t Shards_ = Shards>
+    static std::enable_if_t<(Shards_ > 1)> set_heap_size(size_t length)
+    {
+      static_assert(Shards_ == Shards, "Don't set SFINAE parameter!");
+      GlobalR::set_heap_size(length);
+    }
   };
 } // namespace snmalloc
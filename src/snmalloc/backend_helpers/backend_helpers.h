@@ -1,6 +1,7 @@
 #include "../mem/mem.h"
 #include "authmap.h"
 #include "buddy.h"
+#include "buddycachestats.h"
 #include "commitrange.h"
 #include "commonconfig.h"
 #include "defaultpagemapentry.h"
@@ -9,10 +10,12 @@
 #include "indirectrange.h"
 #include "largebuddyrange.h"
 #include "logrange.h"
+#include "nolockrange.h"
 #include "pagemap.h"
 #include "pagemapregisterrange.h"
 #include "palrange.h"
 #include "range_helpers.h"
+#include "shardedrange.h"
 #include "smallbuddyrange.h"
 #include "staticconditionalrange.h"
 #include "statsrange.h"
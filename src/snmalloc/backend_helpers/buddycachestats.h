@@ -0,0 +1,57 @@
+#pragma once
+
+#include "../ds/ds.h"
+
+#include <atomic>
+
+namespace snmalloc
+{
+  /**
+   * The layers of buddy allocators that cache free address space in the
+   * backend.
+   */
+  enum class BuddyLayer
+  {
+    /// Buddy allocators that cover the whole address space, with no parent
+    /// to return memory to.  These are shared by all allocators.
+    Global,
+    /// Other buddy allocators of chunks, which mostly cache for a single
+    /// allocator.
+    Local,
+    /// Buddy allocators of less than a chunk, used for metadata.
+    Small,
+    NumLayers
+  };
+
+  static constexpr size_t NUM_BUDDY_LAYERS =
+    static_cast<size_t>(BuddyLayer::NumLayers);
+
+  /**
+   * Process-wide totals of the bytes held free by each layer of buddy
+   * allocators.  These are updated as blocks enter and leave the buddy
+   * allocators, which is only on the backend's slow paths.
+   */
+  class BuddyCacheStats
+  {
+    static inline std::atomic<size_t> cached[NUM_BUDDY_LAYERS]{};
+
+  public:
+    static void add(BuddyLayer layer, size_t size)
+    {
+      cached[static_cast<size_t>(layer)].fetch_add(
+        size, std::memory_order_relaxed);
+    }
+
+    static void remove(BuddyLayer layer, size_t size)
+    {
+      cached[static_cast<size_t>(layer)].fetch_sub(
+        size, std::memory_order_relaxed);
+    }
+
+    static size_t get(BuddyLayer layer)
+    {
+      return cached[static_cast<size_t>(layer)].load(
+        std::memory_order_relaxed);
+    }
+  };
+} // namespace snmalloc
@@ -1,4 +1,5 @@
 #pragma once
+#include "../ds/ds.h"
 #include "../pal/pal.h"
 #include "empty_range.h"
 #include "range_helpers.h"
@@ -34,7 +35,25 @@ namespace snmalloc
           PAL::page_size);
         auto range = parent.alloc_range(size);
         if (range != nullptr)
-          PAL::template notify_using<NoZero>(range.unsafe_ptr(), size);
+        {
+          EventCounters::count_backend(Event::PalCommit);
+          SNMALLOC_TRACEPOINT2(pal_commit, address_cast(range), size);
+          if constexpr (pal_supports<FallibleCommit, PAL>)
+          {
+            // Fail as if the parent had no memory, so that the frontend
+            // returns cached memory and retries.
+            if (SNMALLOC_UNLIKELY(
+                  !PAL::try_notify_using(range.unsafe_ptr(), size)))
+            {
+              parent.dealloc_range(range, size);
+              return nullptr;
+            }
+          }
+          else
+          {
+            PAL::template notify_using<NoZero>(range.unsafe_ptr(), size);
+          }
+        }
         return range;
       }
 
@@ -45,6 +64,8 @@ namespace snmalloc
           "size ({}) must be a multiple of page size ({})",
           size,
           PAL::page_size);
+        EventCounters::count_backend(Event::PalDecommit);
+        SNMALLOC_TRACEPOINT2(pal_decommit, address_cast(base), size);
         PAL::notify_not_using(base.unsafe_ptr(), size);
         parent.dealloc_range(base, size);
       }
@@ -93,6 +93,16 @@ namespace snmalloc
      * (on dealloc and in freelists) otherwise a no-op version is provided.
      */
     bool HasDomesticate = false;
+
+    /**
+     * Is this configuration used by only one thread?  If so, allocators do
+     * not check their message queues on the slow paths, and deallocations
+     * sent by other allocators, which can only be on the same thread, are
+     * processed when the allocator is flushed.  The configuration should
+     * also use ranges that are not locked, such as those selected by the
+     * `IsThreadSafe` parameter of `StandardLocalState`.
+     */
+    bool IsSingleThreaded = false;
   };
 
   /**
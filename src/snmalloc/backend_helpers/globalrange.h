@@ -3,6 +3,8 @@
 #include "../ds/ds.h"
 #include "empty_range.h"
 #include "lockrange.h"
+#include "nolockrange.h"
+#include "shardedrange.h"
 #include "staticrange.h"
 
 namespace snmalloc
@@ -17,4 +19,27 @@ namespace snmalloc
     class Type : public Pipe<ParentRange, LockRange, StaticRange>
     {};
   };
+
+  /**
+   * Makes the supplied ParentRange into a global variable, without a lock.
+   * For configurations used by a single thread.
+   */
+  struct SingleThreadGlobalRange
+  {
+    template<typename ParentRange = EmptyRange<>>
+    class Type : public Pipe<ParentRange, NoLockRange, StaticRange>
+    {};
+  };
+
+  /**
+   * Makes `Count` global copies of the supplied ParentRange, each protected
+   * by its own lock, and splits the memory between them.
+   */
+  template<size_t Count>
+  struct ShardedGlobalRange
+  {
+    template<typename ParentRange = EmptyRange<>>
+    class Type : public Pipe<ParentRange, LockRange, ShardedRange<Count>>
+    {};
+  };
 } // namespace snmalloc
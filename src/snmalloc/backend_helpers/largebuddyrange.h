@@ -3,6 +3,7 @@
 #include "../ds/ds.h"
 #include "../mem/mem.h"
 #include "buddy.h"
+#include "buddycachestats.h"
 #include "empty_range.h"
 #include "range_helpers.h"
 
@@ -172,8 +173,8 @@ namespace snmalloc
    *
    * ParentRange - Represents the range to get memory from to fill this range.
    *
-   * REFILL_SIZE_BITS - Maximum size of a refill, may ask for less during warm
-   * up phase.
+   * REFILL_SIZE_BITS - Size of a refill once warmed up, may ask for less
+   * during warm up phase.
    *
    * MAX_SIZE_BITS - Maximum size that this range will store.
    *
@@ -182,12 +183,18 @@ namespace snmalloc
    *
    * MIN_REFILL_SIZE_BITS - The minimum size that the ParentRange can be asked
    * for
+   *
+   * MAX_REFILL_SIZE_BITS - The maximum size of a refill.  Once the range has
+   * requested more than REFILL_SIZE_BITS in total, refills keep growing in
+   * proportion to the memory requested so far, up to this size, so that large
+   * heaps make fewer requests to the ParentRange.
    */
   template<
     size_t REFILL_SIZE_BITS,
     size_t MAX_SIZE_BITS,
     SNMALLOC_CONCEPT(IsWritablePagemap) Pagemap,
-    size_t MIN_REFILL_SIZE_BITS = 0>
+    size_t MIN_REFILL_SIZE_BITS = 0,
+    size_t MAX_REFILL_SIZE_BITS = REFILL_SIZE_BITS>
   class LargeBuddyRange
   {
     static_assert(
@@ -195,18 +202,43 @@ namespace snmalloc
     static_assert(
       MIN_REFILL_SIZE_BITS <= REFILL_SIZE_BITS,
       "MIN_REFILL_SIZE_BITS > REFILL_SIZE_BITS");
+    static_assert(
+      REFILL_SIZE_BITS <= MAX_REFILL_SIZE_BITS,
+      "REFILL_SIZE_BITS > MAX_REFILL_SIZE_BITS");
+    static_assert(
+      MAX_REFILL_SIZE_BITS <= MAX_SIZE_BITS,
+      "MAX_REFILL_SIZE_BITS > MAX_SIZE_BITS");
 
     /**
-     * Maximum size of a refill
+     * Size of a refill once warmed up
      */
     static constexpr size_t REFILL_SIZE = bits::one_at_bit(REFILL_SIZE_BITS);
 
+    /**
+     * Maximum size of a refill
+     */
+    static constexpr size_t MAX_REFILL_SIZE =
+      bits::one_at_bit(MAX_REFILL_SIZE_BITS);
+
+    /**
+     * Past REFILL_SIZE, each refill is 1/2^HEAP_FRACTION_BITS of the memory
+     * requested so far.
+     */
+    static constexpr size_t HEAP_FRACTION_BITS = 2;
+
     /**
      * Minimum size of a refill
      */
     static constexpr size_t MIN_REFILL_SIZE =
       bits::one_at_bit(MIN_REFILL_SIZE_BITS);
 
+    /**
+     * The layer that the memory cached by this range is accounted to.
+     */
+    static constexpr BuddyLayer LAYER = MAX_SIZE_BITS == (bits::BITS - 1) ?
+      BuddyLayer::Global :
+      BuddyLayer::Local;
+
   public:
     template<typename ParentRange = EmptyRange<>>
     class Type : public ContainsParent<ParentRange>
@@ -220,6 +252,12 @@ namespace snmalloc
        */
       size_t requested_total = 0;
 
+      /**
+       * The `MemoryPressure` epoch when `requested_total` was last reset.
+       * After a purge, refills start small again.
+       */
+      size_t purge_epoch = 0;
+
       /**
        * Buddy allocator used to represent this range of memory.
        */
@@ -244,6 +282,7 @@ namespace snmalloc
         {
           if (overflow != nullptr)
           {
+            BuddyCacheStats::remove(LAYER, bits::one_at_bit(MAX_SIZE_BITS));
             parent.dealloc_range(overflow, bits::one_at_bit(MAX_SIZE_BITS));
           }
         }
@@ -262,6 +301,7 @@ namespace snmalloc
       {
         range_to_pow_2_blocks<MIN_CHUNK_BITS>(
           base, length, [this](capptr::Arena<void> base, size_t align, bool) {
+            BuddyCacheStats::add(LAYER, align);
             auto overflow =
               capptr::Arena<void>::unsafe_from(reinterpret_cast<void*>(
                 buddy_large.add_block(base.unsafe_uintptr(), align)));
@@ -270,23 +310,50 @@ namespace snmalloc
           });
       }
 
+      /**
+       * Use amount currently requested to determine refill size.
+       * This will gradually increase the usage of the parent range.
+       * So small examples can grow local caches slowly, and larger
+       * examples will grow them by the refill size.
+       *
+       * The heuristic is designed to allocate the following sequence for
+       * 16KiB requests 16KiB, 16KiB, 32Kib, 64KiB, ..., REFILL_SIZE/2,
+       * REFILL_SIZE, REFILL_SIZE, ... Hence if this if they are coming from
+       * a contiguous aligned range, then they could be consolidated.  This
+       * depends on the ParentRange behaviour.
+       *
+       * Past REFILL_SIZE, refills grow geometrically with the memory
+       * requested so far, up to MAX_REFILL_SIZE.  After memory has been
+       * purged, the sequence starts again from the beginning.
+       */
+      size_t refill_target()
+      {
+        auto epoch = MemoryPressure::get_epoch();
+        if (epoch != purge_epoch)
+        {
+          purge_epoch = epoch;
+          requested_total = 0;
+        }
+
+        size_t refill_size = bits::min(REFILL_SIZE, requested_total);
+        if constexpr (MAX_REFILL_SIZE > REFILL_SIZE)
+        {
+          refill_size = bits::max(
+            refill_size,
+            bits::min(MAX_REFILL_SIZE, requested_total >> HEAP_FRACTION_BITS));
+        }
+        refill_size =
+          bits::min(refill_size, MemoryBudget::limit_refill(MAX_REFILL_SIZE));
+        return bits::max(refill_size, MIN_REFILL_SIZE);
+      }
+
       capptr::Arena<void> refill(size_t size)
       {
+        EventCounters::count_backend(Event::BuddyRefill);
+        SNMALLOC_TRACEPOINT1(buddy_refill, size);
         if (ParentRange::Aligned)
         {
-          // Use amount currently requested to determine refill size.
-          // This will gradually increase the usage of the parent range.
-          // So small examples can grow local caches slowly, and larger
-          // examples will grow them by the refill size.
-          //
-          // The heuristic is designed to allocate the following sequence for
-          // 16KiB requests 16KiB, 16KiB, 32Kib, 64KiB, ..., REFILL_SIZE/2,
-          // REFILL_SIZE, REFILL_SIZE, ... Hence if this if they are coming from
-          // a contiguous aligned range, then they could be consolidated.  This
-          // depends on the ParentRange behaviour.
-          size_t refill_size = bits::min(REFILL_SIZE, requested_total);
-          refill_size = bits::max(refill_size, MIN_REFILL_SIZE);
-          refill_size = bits::max(refill_size, size);
+          size_t refill_size = bits::max(refill_target(), size);
           refill_size = bits::next_pow2(refill_size);
 
           auto refill_range = parent.alloc_range(refill_size);
@@ -298,12 +365,6 @@ namespace snmalloc
           return refill_range;
         }
 
-        // Note the unaligned parent path does not use
-        // requested_total in the heuristic for the initial size
-        // this is because the request needs to introduce alignment.
-        // Currently the unaligned variant is not used as a local cache.
-        // So the gradual growing of refill_size is not needed.
-
         // Need to overallocate to get the alignment right.
         bool overflow = false;
         size_t needed_size = bits::umul(size, 2, overflow);
@@ -312,7 +373,10 @@ namespace snmalloc
           return nullptr;
         }
 
-        auto refill_size = bits::max(needed_size, REFILL_SIZE);
+        // The request needs to introduce alignment, so is at least twice the
+        // size, but otherwise follows the same heuristic as the aligned case.
+        auto refill_size =
+          bits::next_pow2(bits::max(needed_size, refill_target()));
         while (needed_size <= refill_size)
         {
           auto refill = parent.alloc_range(refill_size);
@@ -324,7 +388,7 @@ namespace snmalloc
 
             SNMALLOC_ASSERT(refill_size < bits::one_at_bit(MAX_SIZE_BITS));
             static_assert(
-              (REFILL_SIZE < bits::one_at_bit(MAX_SIZE_BITS)) ||
+              (MAX_REFILL_SIZE < bits::one_at_bit(MAX_SIZE_BITS)) ||
                 ParentRange::Aligned,
               "Required to prevent overflow.");
 
@@ -366,7 +430,10 @@ namespace snmalloc
           reinterpret_cast<void*>(buddy_large.remove_block(size)));
 
         if (result != nullptr)
+        {
+          BuddyCacheStats::remove(LAYER, size);
           return result;
+        }
 
         return refill(size);
       }
@@ -385,11 +452,43 @@ namespace snmalloc
           }
         }
 
+        BuddyCacheStats::add(LAYER, size);
         auto overflow =
           capptr::Arena<void>::unsafe_from(reinterpret_cast<void*>(
             buddy_large.add_block(base.unsafe_uintptr(), size)));
         dealloc_overflow(overflow);
       }
+
+      /**
+       * Return all the memory held by this buddy allocator to the parent
+       * range.  The refill heuristic is also reset, so subsequent refills
+       * start small again.  Only available if the parent supports
+       * deallocation.
+       */
+      template<bool exists = MAX_SIZE_BITS != (bits::BITS - 1)>
+      std::enable_if_t<exists> purge()
+      {
+        static_assert(
+          MAX_SIZE_BITS != (bits::BITS - 1), "Don't set SFINAE parameter");
+        // Remove the largest blocks first, so that no block is split.
+        for (size_t size = bits::one_at_bit(MAX_SIZE_BITS - 1);
+             size >= MIN_CHUNK_SIZE;
+             size >>= 1)
+        {
+          while (true)
+          {
+            auto block = buddy_large.remove_block(size);
+            if (block == BuddyChunkRep<Pagemap>::null)
+              break;
+
+            BuddyCacheStats::remove(LAYER, size);
+            parent.dealloc_range(
+              capptr::Arena<void>::unsafe_from(reinterpret_cast<void*>(block)),
+              size);
+          }
+        }
+        requested_total = 0;
+      }
     };
   };
 } // namespace snmalloc
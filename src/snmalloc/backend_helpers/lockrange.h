@@ -6,12 +6,13 @@
 namespace snmalloc
 {
   /**
-   * Protect the ParentRange with a spin lock.
+   * Protect the ParentRange with a spin lock, whose lock word is a `Word`.
    *
    * Accesses via the ancestor() mechanism will bypass the lock and so
    * should be used only where the resulting data races are acceptable.
    */
-  struct LockRange
+  template<typename Word = FlagWord>
+  struct BasicLockRange
   {
     template<typename ParentRange = EmptyRange<>>
     class Type : public ContainsParent<ParentRange>
@@ -22,7 +23,7 @@ namespace snmalloc
        * This is infrequently used code, a spin lock simplifies the code
        * considerably, and should never be on the fast path.
        */
-      FlagWord spin_lock{};
+      Word spin_lock{"global_range"};
 
     public:
       static constexpr bool Aligned = ParentRange::Aligned;
@@ -35,15 +36,22 @@ namespace snmalloc
 
       CapPtr<void, ChunkBounds> alloc_range(size_t size)
       {
-        FlagLock lock(spin_lock);
+        BasicFlagLock<Word> lock(spin_lock);
         return parent.alloc_range(size);
       }
 
       void dealloc_range(CapPtr<void, ChunkBounds> base, size_t size)
       {
-        FlagLock lock(spin_lock);
+        BasicFlagLock<Word> lock(spin_lock);
         parent.dealloc_range(base, size);
       }
     };
   };
+
+  using LockRange = BasicLockRange<>;
+
+  /**
+   * A `LockRange` that may be placed in memory shared between processes.
+   */
+  using SharedLockRange = BasicLockRange<SharedFlagWord>;
 } // namespace snmalloc
@@ -99,7 +99,8 @@ namespace snmalloc
      */
     static void register_range(capptr::Arena<void> p, size_t sz)
     {
-      concretePagemap.register_range(address_cast(p), sz);
+      OverheadStats::add_pagemap(
+        concretePagemap.register_range(address_cast(p), sz));
       if constexpr (!CONSOLIDATE_PAL_ALLOCS)
       {
         // Mark start of allocation in pagemap.
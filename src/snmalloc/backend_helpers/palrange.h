@@ -34,6 +34,7 @@ namespace snmalloc
 #ifdef SNMALLOC_TRACING
         message<1024>("Pal range alloc: {} ({})", result.unsafe_ptr(), size);
 #endif
+        EventLog::record(LogEvent::PalReserve, address_cast(result), size);
         return result;
       }
       else
@@ -43,6 +44,7 @@ namespace snmalloc
 #ifdef SNMALLOC_TRACING
         message<1024>("Pal range alloc: {} ({})", result.unsafe_ptr(), size);
 #endif
+        EventLog::record(LogEvent::PalReserve, address_cast(result), size);
 
         return result;
       }
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "../ds/ds.h"
+#include "empty_range.h"
+
+#include <atomic>
+
+namespace snmalloc
+{
+  /**
+   * Makes `Count` global copies of the supplied ParentRange, and splits the
+   * memory between them, so that threads allocating concurrently mostly use
+   * different copies, and so take different locks.
+   *
+   * Memory is striped across the copies by address, in aligned blocks of
+   * `stripe_size()` bytes, and is always returned to the copy for its
+   * address so that it can be coalesced with its buddies.  Each instance of
+   * this range allocates from a home copy, chosen round robin, and steals
+   * from the others when that is exhausted.  Allocations larger than a
+   * stripe cannot be satisfied.
+   */
+  template<size_t Count>
+  struct ShardedRange
+  {
+    static_assert(Count > 0, "ShardedRange requires at least one shard.");
+
+    template<typename ParentRange = EmptyRange<>>
+    class Type
+    {
+      static inline ParentRange shards[Count]{};
+
+      static inline size_t stripe_bits{bits::BITS - 1};
+
+      static inline std::atomic<size_t> next_home{0};
+
+      /**
+       * The copy to allocate from first.
+       */
+      size_t home{next_home.fetch_add(1, std::memory_order_relaxed) % Count};
+
+      static ParentRange& shard_for(address_t a)
+      {
+        return shards[(a >> stripe_bits) % Count];
+      }
+
+    public:
+      static constexpr bool Aligned = ParentRange::Aligned;
+
+      static_assert(
+        ParentRange::ConcurrencySafe,
+        "ShardedRange requires a concurrency safe parent.");
+
+      static constexpr bool ConcurrencySafe = true;
+
+      using ChunkBounds = typename ParentRange::ChunkBounds;
+
+      /**
+       * Set the size of the stripes so that a heap of `length` bytes is
+       * spread across all of the copies.  Must be called before any memory
+       * is added to the range.
+       */
+      static void set_heap_size(size_t length)
+      {
+        auto share = length / Count;
+        stripe_bits = (share < MIN_CHUNK_SIZE) ?
+          MIN_CHUNK_BITS :
+          (bits::BITS - 1) - bits::clz(share);
+      }
+
+      static size_t stripe_size()
+      {
+        return bits::one_at_bit(stripe_bits);
+      }
+
+      CapPtr<void, ChunkBounds> alloc_range(size_t size)
+      {
+        for (size_t i = 0; i < Count; i++)
+        {
+          auto result = shards[(home + i) % Count].alloc_range(size);
+          if (result != nullptr)
+            return result;
+        }
+        return nullptr;
+      }
+
+      void dealloc_range(CapPtr<void, ChunkBounds> base, size_t size)
+      {
+        // Larger blocks are aligned, so are made of whole stripes.
+        auto stripe = stripe_size();
+        while (size > stripe)
+        {
+          shard_for(address_cast(base)).dealloc_range(base, stripe);
+          base = pointer_offset(base, stripe);
+          size -= stripe;
+        }
+        shard_for(address_cast(base)).dealloc_range(base, size);
+      }
+    };
+  };
+} // namespace snmalloc
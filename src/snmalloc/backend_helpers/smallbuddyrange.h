@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../pal/pal.h"
+#include "buddycachestats.h"
 #include "empty_range.h"
 #include "range_helpers.h"
 
@@ -176,6 +177,7 @@ namespace snmalloc
           [this](CapPtr<void, ChunkBounds> base, size_t align, bool) {
             if (align < MIN_CHUNK_SIZE)
             {
+              BuddyCacheStats::add(BuddyLayer::Small, align);
               CapPtr<void, ChunkBounds> overflow =
                 buddy_small
                   .add_block(
@@ -183,8 +185,12 @@ namespace snmalloc
                     align)
                   .template as_reinterpret<void>();
               if (overflow != nullptr)
+              {
+                BuddyCacheStats::remove(
+                  BuddyLayer::Small, bits::one_at_bit(MIN_CHUNK_BITS));
                 parent.dealloc_range(
                   overflow, bits::one_at_bit(MIN_CHUNK_BITS));
+              }
             }
             else
             {
@@ -219,6 +225,7 @@ namespace snmalloc
         auto result = buddy_small.remove_block(size);
         if (result != nullptr)
         {
+          BuddyCacheStats::remove(BuddyLayer::Small, size);
           result->left = nullptr;
           result->right = nullptr;
           return result.template as_reinterpret<void>();
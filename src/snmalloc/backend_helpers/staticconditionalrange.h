@@ -69,6 +69,18 @@ namespace snmalloc
         parent.dealloc_range(base, size);
       }
 
+      /**
+       * Return the memory cached by the optional range to the parent.  If
+       * the optional range is disabled, it holds no memory.
+       */
+      void purge()
+      {
+        if (disable_range_)
+          return;
+
+        parent.purge();
+      }
+
       static void disable_range()
       {
         disable_range_ = true;
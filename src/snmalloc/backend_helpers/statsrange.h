@@ -1,5 +1,6 @@
 #pragma once
 
+#include "../ds/ds.h"
 #include "empty_range.h"
 #include "range_helpers.h"
 
@@ -8,17 +9,28 @@
 namespace snmalloc
 {
   /**
-   * Used to measure memory usage.
+   * Used to measure memory usage, and to enforce the `HeapLimit`.  If
+   * `IsThreadSafe` is false, the usage is kept in plain variables, so the
+   * range must be used by only one thread.
+   *
+   * If `TrackHeapLimit` is false, the memory is not counted towards the
+   * process-wide `HeapLimit`, whose usage is shared with other threads and
+   * so always updated atomically.  By default it is tracked only by ranges
+   * that are thread safe.
    */
-  struct StatsRange
+  template<bool IsThreadSafe = true, bool TrackHeapLimit = IsThreadSafe>
+  struct BasicStatsRange
   {
     template<typename ParentRange = EmptyRange<>>
     class Type : public ContainsParent<ParentRange>
     {
       using ContainsParent<ParentRange>::parent;
 
-      static inline std::atomic<size_t> current_usage{};
-      static inline std::atomic<size_t> peak_usage{};
+      using Counter =
+        std::conditional_t<IsThreadSafe, std::atomic<size_t>, size_t>;
+
+      static inline Counter current_usage{};
+      static inline Counter peak_usage{};
 
     public:
       static constexpr bool Aligned = ParentRange::Aligned;
@@ -31,8 +43,19 @@ namespace snmalloc
 
       CapPtr<void, ChunkBounds> alloc_range(size_t size)
       {
+        if constexpr (TrackHeapLimit)
+        {
+          if (!HeapLimit::acquire(size))
+            return nullptr;
+        }
+
         auto result = parent.alloc_range(size);
-        if (result != nullptr)
+        if (result == nullptr)
+        {
+          if constexpr (TrackHeapLimit)
+            HeapLimit::release(size);
+        }
+        else if constexpr (IsThreadSafe)
         {
           auto prev = current_usage.fetch_add(size);
           auto curr = peak_usage.load();
@@ -42,27 +65,36 @@ namespace snmalloc
               break;
           }
         }
+        else
+        {
+          current_usage += size;
+          peak_usage = bits::max(peak_usage, current_usage);
+        }
         return result;
       }
 
       void dealloc_range(CapPtr<void, ChunkBounds> base, size_t size)
       {
         current_usage -= size;
+        if constexpr (TrackHeapLimit)
+          HeapLimit::release(size);
         parent.dealloc_range(base, size);
       }
 
       size_t get_current_usage()
       {
-        return current_usage.load();
+        return current_usage;
       }
 
       size_t get_peak_usage()
       {
-        return peak_usage.load();
+        return peak_usage;
       }
     };
   };
 
+  using StatsRange = BasicStatsRange<>;
+
   template<typename StatsR1, typename StatsR2>
   class StatsCombiner
   {
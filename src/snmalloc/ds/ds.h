@@ -7,7 +7,13 @@
 #include "aba.h"
 #include "allocconfig.h"
 #include "entropy.h"
+#include "eventlog.h"
+#include "eventcounters.h"
 #include "flaglock.h"
+#include "heaplimit.h"
+#include "memorybudget.h"
 #include "mpmcstack.h"
 #include "pagemap.h"
 #include "singleton.h"
+#include "statspublisher.h"
+#include "tracepoints.h"
@@ -0,0 +1,219 @@
+#pragma once
+
+#include "../ds_core/ds_core.h"
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+namespace snmalloc
+{
+  /**
+   * Are slow-path event counters maintained?  Define
+   * `SNMALLOC_EVENT_COUNTERS` to enable them.  When disabled, the counting
+   * calls compile to nothing.
+   */
+#ifdef SNMALLOC_EVENT_COUNTERS
+  static constexpr bool EventCountersEnabled = true;
+#else
+  static constexpr bool EventCountersEnabled = false;
+#endif
+
+  /**
+   * Expensive paths whose frequency is counted.
+   */
+  enum class Event : size_t
+  {
+    /// An allocation that needed a new slab.
+    SmallAllocSlow,
+    /// A deallocation that woke a slab, emptied a slab, or freed a large
+    /// allocation.
+    DeallocLocalSlow,
+    /// A call that found messages in the allocator's queue to process.
+    MessageQueue,
+    /// A round of sending the remote deallocation cache.
+    RemotePostRound,
+    /// A buddy allocator refilling from its parent range.
+    BuddyRefill,
+    /// Memory being committed with the PAL.
+    PalCommit,
+    /// Memory being decommitted with the PAL.
+    PalDecommit,
+    NumEvents
+  };
+
+  static constexpr size_t NUM_EVENTS = static_cast<size_t>(Event::NumEvents);
+
+  /**
+   * Human-readable names for each `Event`, in order.
+   */
+  static constexpr const char* event_names[NUM_EVENTS] = {
+    "small_alloc_slow",
+    "dealloc_local_slow",
+    "message_queue",
+    "remote_post_round",
+    "buddy_refill",
+    "pal_commit",
+    "pal_decommit"};
+
+  /**
+   * A set of event counts.
+   *
+   * Counters embedded in an allocator have a single writer, and are updated
+   * with `count`, which does not need an atomic read-modify-write.  They can
+   * be read from other threads, for aggregation, at any time.  Counters that
+   * are shared between threads are updated with `count_shared`.
+   */
+  class EventCounters
+  {
+    std::atomic<uint64_t> counters[NUM_EVENTS]{};
+
+  public:
+    constexpr EventCounters() = default;
+
+    SNMALLOC_FAST_PATH void count(Event e)
+    {
+      if constexpr (EventCountersEnabled)
+      {
+        auto& c = counters[static_cast<size_t>(e)];
+        c.store(
+          c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+      }
+      else
+      {
+        UNUSED(e);
+      }
+    }
+
+    SNMALLOC_FAST_PATH void count_shared(Event e)
+    {
+      if constexpr (EventCountersEnabled)
+      {
+        counters[static_cast<size_t>(e)].fetch_add(
+          1, std::memory_order_relaxed);
+      }
+      else
+      {
+        UNUSED(e);
+      }
+    }
+
+    uint64_t get(Event e) const
+    {
+      return counters[static_cast<size_t>(e)].load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Add the counts from `other` into this set.  This set must not be
+     * updated concurrently.
+     */
+    void add(const EventCounters& other)
+    {
+      for (size_t i = 0; i < NUM_EVENTS; i++)
+      {
+        counters[i].store(
+          counters[i].load(std::memory_order_relaxed) +
+            other.counters[i].load(std::memory_order_relaxed),
+          std::memory_order_relaxed);
+      }
+    }
+
+    /**
+     * Counters for events in the backend that happen outside the scope of
+     * any allocator, see `BackendEventScope`.  These are shared between
+     * threads.
+     */
+    static EventCounters& backend()
+    {
+      static EventCounters global;
+      return global;
+    }
+
+  private:
+    friend class BackendEventScope;
+
+    /**
+     * The counters of the allocator on whose behalf this thread is running
+     * the backend, or null.
+     */
+    static inline thread_local EventCounters* current_backend{nullptr};
+
+  public:
+    /**
+     * Count an event in the backend.  The ranges of the backend are shared
+     * between allocators, so the event is counted against the allocator that
+     * this thread is running the backend for, if any, and in `backend()`
+     * otherwise.
+     */
+    SNMALLOC_FAST_PATH static void count_backend(Event e)
+    {
+      if constexpr (EventCountersEnabled)
+      {
+        auto* c = current_backend;
+        if (c != nullptr)
+          c->count(e);
+        else
+          backend().count_shared(e);
+      }
+      else
+      {
+        UNUSED(e);
+      }
+    }
+  };
+
+  /**
+   * Stands in for `EventCounters` in an allocator when event counters are
+   * disabled, so that the allocator holds no counters.  It reads as a set of
+   * `EventCounters` that are all zero.
+   */
+  class NoEventCounters
+  {
+    static inline const EventCounters zero{};
+
+  public:
+    SNMALLOC_FAST_PATH void count(Event) {}
+
+    operator const EventCounters&() const
+    {
+      return zero;
+    }
+  };
+
+  using EventCountersField =
+    std::conditional_t<EventCountersEnabled, EventCounters, NoEventCounters>;
+
+  /**
+   * While in scope, the events counted by `EventCounters::count_backend` on
+   * this thread are counted against the given allocator's counters.  Does
+   * nothing if event counters are disabled.
+   */
+  class BackendEventScope
+  {
+    EventCounters* prev;
+
+  public:
+    template<typename Counters>
+    SNMALLOC_FAST_PATH BackendEventScope(Counters& counters)
+    {
+      if constexpr (EventCountersEnabled)
+      {
+        prev = EventCounters::current_backend;
+        EventCounters::current_backend = &counters;
+      }
+      else
+      {
+        UNUSED(counters);
+      }
+    }
+
+    SNMALLOC_FAST_PATH ~BackendEventScope()
+    {
+      if constexpr (EventCountersEnabled)
+        EventCounters::current_backend = prev;
+    }
+
+    BackendEventScope(const BackendEventScope&) = delete;
+    BackendEventScope& operator=(const BackendEventScope&) = delete;
+  };
+} // namespace snmalloc
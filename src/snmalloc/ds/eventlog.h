@@ -0,0 +1,294 @@
+#pragma once
+
+#include "../aal/aal.h"
+#include "../ds_core/ds_core.h"
+
+#include <atomic>
+#include <cstdint>
+
+namespace snmalloc
+{
+  /**
+   * Is the binary event log maintained?  Define `SNMALLOC_EVENT_LOG` to
+   * enable it.  When disabled, the recording calls compile to nothing.
+   */
+#ifdef SNMALLOC_EVENT_LOG
+  static constexpr bool EventLogEnabled = true;
+#else
+  static constexpr bool EventLogEnabled = false;
+#endif
+
+  /**
+   * Events recorded in the event log.  These are recorded at the points that
+   * `SNMALLOC_TRACING` reports, with the values that it prints as payload.
+   */
+  enum class LogEvent : uint32_t
+  {
+    /// An allocator was initialised: (core allocator, local cache).
+    Init,
+    /// An allocator flushed its caches: (core allocator, 0).
+    Flush,
+    /// An allocator was torn down: (core allocator, local cache).
+    Teardown,
+    /// A new core allocator was made: (core allocator, 0).
+    MakeAllocator,
+    /// A cache was attached to a core allocator: (core allocator, 0).
+    AttachCache,
+    /// An allocation needed a new slab: (size, slab size).
+    SmallAllocSlow,
+    /// A large allocation: (address, size).
+    LargeAlloc,
+    /// A large deallocation: (address, size).
+    LargeDealloc,
+    /// A deallocation woke a slab: (object, sizeclass).
+    SlabWake,
+    /// A slab became unused: (slab, sizeclass).
+    SlabUnused,
+    /// An object was freed to another allocator: (address, 0).
+    RemoteDealloc,
+    /// Remote deallocations were processed: (core allocator, 0).
+    HandleRemote,
+    /// The backend allocated a chunk: (address, size).
+    AllocChunk,
+    /// The backend failed to allocate a chunk: (0, size).
+    OutOfMemory,
+    /// Address space was reserved from the platform: (address, size).
+    PalReserve,
+    NumLogEvents
+  };
+
+  static constexpr size_t NUM_LOG_EVENTS =
+    static_cast<size_t>(LogEvent::NumLogEvents);
+
+  /**
+   * Human-readable names for each `LogEvent`, in order.
+   */
+  static constexpr const char* log_event_names[NUM_LOG_EVENTS] = {
+    "init",
+    "flush",
+    "teardown",
+    "make_allocator",
+    "attach_cache",
+    "small_alloc_slow",
+    "large_alloc",
+    "large_dealloc",
+    "slab_wake",
+    "slab_unused",
+    "remote_dealloc",
+    "handle_remote",
+    "alloc_chunk",
+    "out_of_memory",
+    "pal_reserve"};
+
+  /**
+   * A single entry in the event log.
+   */
+  struct LogRecord
+  {
+    /// The value of `Aal::tick()` when the event was recorded.
+    uint64_t tick{0};
+    LogEvent event{};
+    uint32_t reserved{0};
+    uint64_t payload[2]{};
+  };
+
+  /**
+   * A binary log of allocator events, much cheaper to record than the text
+   * of `SNMALLOC_TRACING`, so that it can be left enabled without hiding
+   * timing-dependent behaviour.
+   *
+   * Each thread records into its own ring buffer, claimed on its first
+   * event, which keeps the most recent `RING_SIZE` records.  A thread's ring
+   * is released when its allocator is torn down, and may then be claimed by
+   * another thread, which continues after the records of the earlier ones.
+   * Only `MAX_RINGS` threads can record at once; others drop their events.
+   * The log is written out with `write`, and decoded with the `eventlog`
+   * tool.
+   */
+  class EventLog
+  {
+  public:
+    static constexpr size_t RING_SIZE = 4096;
+
+    static constexpr size_t MAX_RINGS = 64;
+
+    /// "snmlog01", as a little-endian integer.
+    static constexpr uint64_t MAGIC = 0x31306c6f676d6e73;
+
+    static constexpr uint32_t VERSION = 1;
+
+    /**
+     * The header of a written log.  It is followed, for each ring, by a
+     * `RingHeader` and then the ring's records, oldest first.
+     */
+    struct Header
+    {
+      uint64_t magic;
+      uint32_t version;
+      uint32_t record_size;
+      uint64_t rings;
+      /// Events not recorded because there was no free ring for the thread.
+      uint64_t dropped;
+    };
+
+    struct RingHeader
+    {
+      uint64_t index;
+      /// Records written in total, including any that were overwritten.
+      uint64_t written;
+      /// Records that follow.
+      uint64_t count;
+    };
+
+  private:
+    struct Ring
+    {
+      std::atomic<bool> claimed{false};
+      std::atomic<uint64_t> next{0};
+      LogRecord records[RING_SIZE];
+    };
+
+    static inline std::atomic<uint64_t> dropped{0};
+
+    static Ring* rings()
+    {
+      // Constant initialised, so that there is no guard on first use.
+      SNMALLOC_REQUIRE_CONSTINIT static Ring r[MAX_RINGS];
+      return r;
+    }
+
+    static SNMALLOC_SLOW_PATH Ring* claim()
+    {
+      auto* r = rings();
+      for (size_t i = 0; i < MAX_RINGS; i++)
+      {
+        if (
+          !r[i].claimed.load(std::memory_order_relaxed) &&
+          !r[i].claimed.exchange(true, std::memory_order_acquire))
+          return &r[i];
+      }
+      return nullptr;
+    }
+
+    static Ring*& current()
+    {
+      static thread_local Ring* ring = nullptr;
+      return ring;
+    }
+
+  public:
+    /**
+     * Record `e` with up to two words of payload.
+     */
+    static SNMALLOC_FAST_PATH void
+    record(LogEvent e, uint64_t a = 0, uint64_t b = 0)
+    {
+      if constexpr (EventLogEnabled)
+      {
+        auto& ring = current();
+        if (SNMALLOC_UNLIKELY(ring == nullptr))
+        {
+          ring = claim();
+          if (ring == nullptr)
+          {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+          }
+        }
+
+        // Only this thread writes to the ring.
+        auto n = ring->next.load(std::memory_order_relaxed);
+        auto& r = ring->records[n % RING_SIZE];
+        r.tick = Aal::tick();
+        r.event = e;
+        r.reserved = 0;
+        r.payload[0] = a;
+        r.payload[1] = b;
+        ring->next.store(n + 1, std::memory_order_release);
+      }
+      else
+      {
+        UNUSED(e, a, b);
+      }
+    }
+
+    /**
+     * Release the calling thread's ring, so that another thread can claim
+     * it.  Its records are kept.  If this thread records again, it claims a
+     * ring again.
+     */
+    static void release()
+    {
+      if constexpr (EventLogEnabled)
+      {
+        auto& ring = current();
+        if (ring == nullptr)
+          return;
+        ring->claimed.store(false, std::memory_order_release);
+        ring = nullptr;
+      }
+    }
+
+    /**
+     * Write the log to `sink`, which is called as
+     * `sink(const void* data, size_t length)`.  Threads may continue to
+     * record concurrently, in which case their most recent records may be
+     * missing or incomplete.  This does not allocate.
+     */
+    template<typename Sink>
+    static void write(Sink& sink)
+    {
+      if constexpr (EventLogEnabled)
+      {
+        auto* r = rings();
+
+        // Threads may claim rings while the log is written, so decide which
+        // rings to write first.  Released rings are written too, as they
+        // hold the records of threads that have exited.
+        bool present[MAX_RINGS];
+        Header h{
+          MAGIC,
+          VERSION,
+          sizeof(LogRecord),
+          0,
+          dropped.load(std::memory_order_relaxed)};
+        for (size_t i = 0; i < MAX_RINGS; i++)
+        {
+          present[i] = r[i].next.load(std::memory_order_acquire) != 0;
+          if (present[i])
+            h.rings++;
+        }
+        sink(&h, sizeof(h));
+
+        for (size_t i = 0; i < MAX_RINGS; i++)
+        {
+          if (!present[i])
+            continue;
+
+          auto written = r[i].next.load(std::memory_order_acquire);
+          auto count = bits::min(written, static_cast<uint64_t>(RING_SIZE));
+          RingHeader rh{i, written, count};
+          sink(&rh, sizeof(rh));
+
+          // Oldest first: the part of the ring after the next slot, then the
+          // part before it.
+          auto start = written % RING_SIZE;
+          auto* records = r[i].records;
+          if (count == RING_SIZE)
+          {
+            sink(&records[start], (RING_SIZE - start) * sizeof(LogRecord));
+            sink(&records[0], start * sizeof(LogRecord));
+          }
+          else
+          {
+            sink(&records[0], count * sizeof(LogRecord));
+          }
+        }
+      }
+      else
+      {
+        UNUSED(sink);
+      }
+    }
+  };
+} // namespace snmalloc
@@ -5,9 +5,119 @@
 
 #include <atomic>
 #include <functional>
+#include <type_traits>
 
 namespace snmalloc
 {
+  /**
+   * Is lock contention counted?  Define `SNMALLOC_LOCK_STATS` to enable it.
+   */
+#ifdef SNMALLOC_LOCK_STATS
+  static constexpr bool LockStatsEnabled = true;
+#else
+  static constexpr bool LockStatsEnabled = false;
+#endif
+
+  /**
+   * Counts of the acquisitions of a lock, of those that found it held, and of
+   * the iterations spent waiting for it.  The counts are updated while the
+   * lock is held, so need no atomic read-modify-write, but may be read from
+   * any thread.
+   *
+   * A lock's counts are added to a global list on its first acquisition, so
+   * that they can be reported with `LockStats::iterate`.
+   */
+  class LockStats
+  {
+    const char* name;
+
+    std::atomic<uint64_t> acquisitions{0};
+    std::atomic<uint64_t> contended{0};
+    std::atomic<uint64_t> spins{0};
+
+    bool registered{false};
+    LockStats* next{nullptr};
+
+    static inline std::atomic<LockStats*> head{nullptr};
+
+    static void increment(std::atomic<uint64_t>& c, uint64_t n)
+    {
+      c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+  public:
+    constexpr LockStats(const char* name = "unnamed") : name(name) {}
+
+    /**
+     * Record an acquisition.  Must be called with the lock held.
+     */
+    void record(bool was_contended, uint64_t spin_count)
+    {
+      if (SNMALLOC_UNLIKELY(!registered))
+      {
+        registered = true;
+        auto h = head.load(std::memory_order_relaxed);
+        do
+        {
+          next = h;
+        } while (!head.compare_exchange_weak(
+          h, this, std::memory_order_release, std::memory_order_relaxed));
+      }
+
+      increment(acquisitions, 1);
+      if (was_contended)
+      {
+        increment(contended, 1);
+        increment(spins, spin_count);
+      }
+    }
+
+    const char* get_name() const
+    {
+      return name;
+    }
+
+    uint64_t get_acquisitions() const
+    {
+      return acquisitions.load(std::memory_order_relaxed);
+    }
+
+    uint64_t get_contended() const
+    {
+      return contended.load(std::memory_order_relaxed);
+    }
+
+    uint64_t get_spins() const
+    {
+      return spins.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Iterate the counts of every lock that has been acquired.  Pass
+     * `nullptr` to get the first.
+     */
+    static const LockStats* iterate(const LockStats* prev = nullptr)
+    {
+      if (prev == nullptr)
+        return head.load(std::memory_order_acquire);
+      return prev->next;
+    }
+  };
+
+  /**
+   * Stands in for `LockStats` when lock statistics are disabled.
+   */
+  class NoLockStats
+  {
+  public:
+    constexpr NoLockStats(const char* = nullptr) {}
+
+    void record(bool, uint64_t) {}
+  };
+
+  using LockStatsField =
+    std::conditional_t<LockStatsEnabled, LockStats, NoLockStats>;
+
   /**
    * @brief The DebugFlagWord struct
    * Wrapper for std::atomic_flag so that we can examine
@@ -23,11 +133,18 @@ namespace snmalloc
      */
     std::atomic_bool flag{false};
 
+    /**
+     * @brief stats
+     * Contention statistics, if enabled.
+     */
+    SNMALLOC_NO_UNIQUE_ADDRESS LockStatsField stats;
+
     constexpr DebugFlagWord() = default;
 
-    template<typename... Args>
-    constexpr DebugFlagWord(Args&&... args) : flag(std::forward<Args>(args)...)
-    {}
+    /**
+     * Construct with a name, by which the lock is identified in statistics.
+     */
+    constexpr DebugFlagWord(const char* name) : stats(name) {}
 
     /**
      * @brief set_owner
@@ -85,12 +202,11 @@ namespace snmalloc
   {
     std::atomic_bool flag{false};
 
+    SNMALLOC_NO_UNIQUE_ADDRESS LockStatsField stats;
+
     constexpr ReleaseFlagWord() = default;
 
-    template<typename... Args>
-    constexpr ReleaseFlagWord(Args&&... args)
-    : flag(std::forward<Args>(args)...)
-    {}
+    constexpr ReleaseFlagWord(const char* name) : stats(name) {}
 
     void set_owner() {}
     void clear_owner() {}
@@ -103,16 +219,51 @@ namespace snmalloc
   using FlagWord = DebugFlagWord;
 #endif
 
-  class FlagLock
+  /**
+   * A lock word that may be placed in memory shared between processes.  It
+   * holds only the flag: the owner recorded by `DebugFlagWord` is a thread
+   * identity, which means nothing in another process, and the contention
+   * statistics are kept in this process's memory, shared by every
+   * `SharedFlagWord` in it.
+   */
+  struct SharedFlagWord
+  {
+    static_assert(
+      std::atomic_bool::is_always_lock_free,
+      "A lock shared between processes must be lock free");
+
+    std::atomic_bool flag{false};
+
+    static inline LockStatsField stats{"shared_lock"};
+
+    constexpr SharedFlagWord() = default;
+
+    /**
+     * The name is ignored, as the statistics are not per lock.
+     */
+    constexpr SharedFlagWord(const char*) {}
+
+    void set_owner() {}
+    void clear_owner() {}
+    void assert_not_owned_by_current_thread() {}
+  };
+
+  template<typename Word>
+  class BasicFlagLock
   {
   private:
-    FlagWord& lock;
+    Word& lock;
 
   public:
-    FlagLock(FlagWord& lock) : lock(lock)
+    BasicFlagLock(Word& lock) : lock(lock)
     {
+      // These are only used if lock statistics are enabled.
+      bool contended = false;
+      uint64_t spins = 0;
+
       while (lock.flag.exchange(true, std::memory_order_acquire))
       {
+        contended = true;
         // assert_not_owned_by_current_thread is only called when the first
         // acquiring is failed; which means the lock is already held somewhere
         // else.
@@ -122,15 +273,19 @@ namespace snmalloc
         while (lock.flag.load(std::memory_order_relaxed))
         {
           Aal::pause();
+          spins++;
         }
       }
       lock.set_owner();
+      lock.stats.record(contended, spins);
     }
 
-    ~FlagLock()
+    ~BasicFlagLock()
     {
       lock.clear_owner();
       lock.flag.store(false, std::memory_order_release);
     }
   };
+
+  using FlagLock = BasicFlagLock<FlagWord>;
 } // namespace snmalloc
@@ -0,0 +1,134 @@
+#pragma once
+
+#include "../pal/pal.h"
+
+#include <atomic>
+
+namespace snmalloc
+{
+  /**
+   * Callbacks that return cached memory, so that it can be used elsewhere.
+   * These are run when memory is short: when the `HeapLimit` is reached, or
+   * when the platform refuses to provide more memory.
+   */
+  class MemoryPressure
+  {
+    static inline PalNotifier purge_callbacks;
+
+    static inline std::atomic<size_t> epoch{0};
+
+  public:
+    /**
+     * Register a callback that releases cached memory.
+     *
+     * The object should never be deallocated by the client after calling
+     * this.
+     */
+    static void register_purge(PalNotificationObject* callback)
+    {
+      purge_callbacks.register_notification(callback);
+    }
+
+    /**
+     * Ask every registered cache to give its memory back.
+     */
+    SNMALLOC_SLOW_PATH static void purge()
+    {
+      epoch.fetch_add(1, std::memory_order_relaxed);
+      purge_callbacks.notify_all();
+    }
+
+    /**
+     * Incremented by each purge, so that caches can tell that one has
+     * happened and shrink their refills.
+     */
+    static size_t get_epoch()
+    {
+      return epoch.load(std::memory_order_relaxed);
+    }
+  };
+
+  /**
+   * Process-wide hard limit on the memory committed through all
+   * `StatsRange`s.  A limit of zero means no limit.
+   *
+   * A request that would exceed the limit fails immediately, as it is made
+   * with the backend's locks held.  The frontend then notifies the
+   * `MemoryPressure` callbacks so that cached memory can be returned, and
+   * retries the allocation.  If that also fails, it calls the user's handler
+   * once, in the style of `std::new_handler`, and retries once more if the
+   * handler asks it to.
+   */
+  class HeapLimit
+  {
+    static inline std::atomic<size_t> limit{0};
+
+    /**
+     * Memory committed through all `StatsRange`s.  This is tracked even when
+     * there is no limit, so that a limit can be set at any point.
+     */
+    static inline std::atomic<size_t> usage{0};
+
+    static inline std::atomic<bool (*)(size_t)> handler{nullptr};
+
+  public:
+    /**
+     * Account for `size` bytes about to be committed.  Returns false if this
+     * cannot be done without exceeding the limit.
+     */
+    static bool acquire(size_t size)
+    {
+      auto prev = usage.fetch_add(size, std::memory_order_relaxed);
+      auto l = limit.load(std::memory_order_relaxed);
+      if (SNMALLOC_LIKELY((l == 0) || (prev + size <= l)))
+        return true;
+
+      usage.fetch_sub(size, std::memory_order_relaxed);
+      return false;
+    }
+
+    static void release(size_t size)
+    {
+      usage.fetch_sub(size, std::memory_order_relaxed);
+    }
+
+    /**
+     * Set the limit in bytes.  Zero removes the limit.  Lowering the limit
+     * below the current usage does not release any memory, but subsequent
+     * requests will fail until usage has dropped.
+     */
+    static void set_limit(size_t l)
+    {
+      limit.store(l, std::memory_order_relaxed);
+    }
+
+    static size_t get_limit()
+    {
+      return limit.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Set the handler called when an allocation fails even after purging.
+     * The handler is passed the size of the allocation, and should return
+     * true if it has released memory or raised the limit and the allocation
+     * should be retried.  The memory needed to satisfy the allocation may be
+     * more than its size, as the backend refills its caches in larger blocks.
+     * Returns the previous handler.
+     */
+    static bool (*set_handler(bool (*h)(size_t)))(size_t)
+    {
+      return handler.exchange(h, std::memory_order_acq_rel);
+    }
+
+    /**
+     * Call the handler for a failed allocation of `size` bytes.  Returns
+     * true if the allocation should be retried.  This must not be called
+     * with any backend lock held, as the handler may free memory.
+     */
+    SNMALLOC_SLOW_PATH static bool call_handler(size_t size)
+    {
+      auto h = handler.load(std::memory_order_acquire);
+      return (h != nullptr) && h(size);
+    }
+  };
+} // namespace snmalloc
@@ -0,0 +1,156 @@
+#pragma once
+
+#include "../pal/pal.h"
+#include "allocconfig.h"
+#include "heaplimit.h"
+
+#include <atomic>
+
+namespace snmalloc
+{
+  /**
+   * The memory available to the process, as reported by the platform, for
+   * instance by the cgroup of a container.  This is used to scale the
+   * allocator's caching policy, so that a process in a small container does
+   * not hold as much memory in caches as a process on a large machine.
+   *
+   * The budget is read when the allocator is initialised.  Reading it can
+   * mean reading files, so it is only read again if the program asks for
+   * this with `set_refresh_interval`, in which case one allocator ticker per
+   * interval, across the process, reads it.  A budget of zero means no limit
+   * is known, and the default policy is used.
+   */
+  class MemoryBudget
+  {
+    static inline std::atomic<size_t> budget{0};
+
+    static inline std::atomic<uint64_t> last_refresh_ms{0};
+
+    /**
+     * Minimum time between reads of the limit from the platform.  Zero means
+     * the limit is not read again after initialisation.
+     */
+    static inline std::atomic<uint64_t> refresh_interval_ms{0};
+
+    /**
+     * A single refill, and hence the memory held in any one cache, is limited
+     * to 1/2^CACHE_FRACTION_BITS of the budget.
+     */
+    static constexpr size_t CACHE_FRACTION_BITS = 7;
+
+    /**
+     * Below this budget, unused slabs are returned to the backend as soon as
+     * possible rather than kept for reuse.
+     */
+    static constexpr size_t CONSTRAINED_BUDGET = bits::one_at_bit(30);
+
+    /**
+     * Number of unused slabs per sizeclass kept by an allocator when the
+     * budget is not constrained.
+     */
+    static constexpr size_t SPARE_SLABS = 2;
+
+  public:
+    /**
+     * Set the budget in bytes.  Zero means no limit is known.  If a known
+     * budget shrinks, cached memory is purged so that the process can move
+     * towards the new limit.  Learning of a budget for the first time does
+     * not purge, as the caches were filled under the default policy rather
+     * than a larger budget.
+     */
+    static void set_budget(size_t b)
+    {
+      auto prev = budget.exchange(b, std::memory_order_relaxed);
+      if ((b != 0) && (prev != 0) && (b < prev))
+        MemoryPressure::purge();
+    }
+
+    static size_t get_budget()
+    {
+      return budget.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Read the budget from the platform, if it can report one.
+     */
+    template<typename PAL>
+    static void refresh()
+    {
+      if constexpr (pal_supports<MemoryLimit, PAL>)
+      {
+        set_budget(PAL::get_memory_limit());
+      }
+    }
+
+    /**
+     * Read the budget from the platform again every `ms` milliseconds, so
+     * that changes to the limit are observed.  Zero, the default, stops
+     * this.
+     */
+    static void set_refresh_interval(uint64_t ms)
+    {
+      refresh_interval_ms.store(ms, std::memory_order_relaxed);
+    }
+
+    /**
+     * Called periodically with the current time.  If a refresh interval has
+     * been set, at most one caller per interval reads the budget from the
+     * platform.
+     */
+    template<typename PAL>
+    static void tick(uint64_t now_ms)
+    {
+      if constexpr (pal_supports<MemoryLimit, PAL>)
+      {
+        auto interval = refresh_interval_ms.load(std::memory_order_relaxed);
+        if (SNMALLOC_LIKELY(interval == 0))
+          return;
+
+        auto last = last_refresh_ms.load(std::memory_order_relaxed);
+        if ((now_ms - last) < interval)
+          return;
+
+        if (!last_refresh_ms.compare_exchange_strong(
+              last, now_ms, std::memory_order_relaxed))
+          return;
+
+        refresh<PAL>();
+      }
+      else
+      {
+        UNUSED(now_ms);
+      }
+    }
+
+    /**
+     * Limit a refill of `size` bytes to the proportion of the budget that a
+     * single cache may hold.  The result is a power of two, and is never less
+     * than a chunk.
+     */
+    static size_t limit_refill(size_t size)
+    {
+      auto b = get_budget();
+      if (b == 0)
+        return size;
+
+      auto cap = b >> CACHE_FRACTION_BITS;
+      if (cap < MIN_CHUNK_SIZE)
+        return bits::min(size, MIN_CHUNK_SIZE);
+
+      return bits::min(size, bits::one_at_bit(bits::BITS - 1 - bits::clz(cap)));
+    }
+
+    /**
+     * Number of unused slabs per sizeclass that an allocator keeps, beyond
+     * any it has reserved, before returning them to the backend.
+     */
+    static size_t spare_slabs()
+    {
+      auto b = get_budget();
+      if ((b != 0) && (b < CONSTRAINED_BUDGET))
+        return 0;
+
+      return SPARE_SLABS;
+    }
+  };
+} // namespace snmalloc
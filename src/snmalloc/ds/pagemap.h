@@ -47,25 +47,140 @@ namespace snmalloc
     address_t base{0};
     size_t size{0};
 
-  public:
-    using EntryType = T;
+    /**
+     * For pagemaps without bounds, one bit for each OS page of `body`, set
+     * once `register_range` has committed it, so that each page is counted
+     * once however many ranges share it.  This is reserved alongside the
+     * pagemap, and committed as `register_range` reaches it.
+     */
+    uint64_t* committed{nullptr};
+
+    /**
+     * For pagemaps with bounds, the OS pages of `body` committed by
+     * `register_range`.  The heap of a bounded pagemap is registered in
+     * contiguous pieces, so these marks are exact.
+     */
+    address_t committed_low{0};
+    address_t committed_high{0};
 
     /**
-     * Ensure this range of pagemap is accessible
+     * The size of the entries of a pagemap without bounds.
      */
-    void register_range(address_t p, size_t length)
+    static constexpr size_t entries_size()
     {
-      SNMALLOC_ASSERT(is_initialised());
+      return bits::one_at_bit(PAL::address_bits - GRANULARITY_BITS) *
+        sizeof(T);
+    }
+
+    /**
+     * The size of `committed` for a pagemap without bounds.  The entries may
+     * start part way through a page, so may span one more page than their
+     * size suggests.
+     */
+    static constexpr size_t committed_size()
+    {
+      constexpr size_t BITS = entries_size() / OS_PAGE_SIZE + 1;
+      return bits::align_up(BITS, 64) / 8;
+    }
 
+    /**
+     * Commit the pages of `body` holding the entries for the `length` bytes
+     * at `offset` into the space covered by this pagemap.  Returns the pages
+     * committed.
+     */
+    std::pair<char*, char*> commit_entries(address_t offset, size_t length)
+    {
       // Calculate range in pagemap that is associated to this space.
-      auto first = &body[p >> SHIFT];
-      auto last = &body[(p + length + bits::one_at_bit(SHIFT) - 1) >> SHIFT];
+      auto first = &body[offset >> SHIFT];
+      auto last =
+        &body[(offset + length + bits::one_at_bit(SHIFT) - 1) >> SHIFT];
 
       // Commit OS pages associated to the range.
       auto page_start = pointer_align_down<OS_PAGE_SIZE, char>(first);
       auto page_end = pointer_align_up<OS_PAGE_SIZE, char>(last);
-      size_t using_size = pointer_diff(page_start, page_end);
-      PAL::template notify_using<NoZero>(page_start, using_size);
+      PAL::template notify_using<NoZero>(
+        page_start, pointer_diff(page_start, page_end));
+      return {page_start, page_end};
+    }
+
+    /**
+     * Mark the pages of `body` from `start` to `end` as committed, and return
+     * the number of bytes of them that were not already.
+     */
+    size_t count_committed(address_t start, address_t end)
+    {
+      if constexpr (has_bounds)
+      {
+        if (committed_low == committed_high)
+        {
+          committed_low = start;
+          committed_high = end;
+          return end - start;
+        }
+
+        SNMALLOC_ASSERT((start <= committed_high) && (committed_low <= end));
+        size_t fresh = 0;
+        if (start < committed_low)
+        {
+          fresh += committed_low - start;
+          committed_low = start;
+        }
+        if (end > committed_high)
+        {
+          fresh += end - committed_high;
+          committed_high = end;
+        }
+        return fresh;
+      }
+      else
+      {
+        auto origin = bits::align_down(address_cast(body), OS_PAGE_SIZE);
+        auto first = (start - origin) / OS_PAGE_SIZE;
+        auto last = (end - origin) / OS_PAGE_SIZE;
+
+        // Commit the words of the bitmap for these pages.
+        auto bitmap_start =
+          pointer_align_down<OS_PAGE_SIZE, char>(&committed[first / 64]);
+        auto bitmap_end = pointer_align_up<OS_PAGE_SIZE, char>(
+          &committed[((last - 1) / 64) + 1]);
+        PAL::template notify_using<NoZero>(
+          bitmap_start, pointer_diff(bitmap_start, bitmap_end));
+
+        size_t fresh = 0;
+        for (auto i = first; i < last; i++)
+        {
+          auto bit = uint64_t(1) << (i % 64);
+          if ((committed[i / 64] & bit) == 0)
+          {
+            committed[i / 64] |= bit;
+            fresh += OS_PAGE_SIZE;
+          }
+        }
+        return fresh;
+      }
+    }
+
+  public:
+    using EntryType = T;
+
+    /**
+     * Ensure this range of pagemap is accessible.  Returns the number of
+     * bytes of the pagemap that were committed, excluding any pages that were
+     * committed by earlier calls.
+     */
+    size_t register_range(address_t p, size_t length)
+    {
+      SNMALLOC_ASSERT(is_initialised());
+
+      if constexpr (has_bounds)
+      {
+        if ((p < base) || (p - base + length > size))
+          PAL::error("Internal error: Pagemap registering out of range.");
+        p = p - base;
+      }
+
+      auto [page_start, page_end] = commit_entries(p, length);
+      return count_committed(address_cast(page_start), address_cast(page_end));
     }
 
     constexpr FlatPagemap() = default;
@@ -81,9 +196,7 @@ namespace snmalloc
     {
       static_assert(
         has_bounds_ == has_bounds, "Don't set SFINAE template parameter!");
-      constexpr size_t COVERED_BITS = PAL::address_bits - GRANULARITY_BITS;
-      constexpr size_t ENTRIES = bits::one_at_bit(COVERED_BITS);
-      return ENTRIES * sizeof(T);
+      return entries_size() + committed_size();
     }
 
     /**
@@ -101,6 +214,7 @@ namespace snmalloc
         has_bounds_ == has_bounds, "Don't set SFINAE template parameter!");
       body = address;
       body_opt = address;
+      committed = pointer_offset<uint64_t>(address, entries_size());
     }
 
     /**
@@ -174,7 +288,7 @@ namespace snmalloc
 
       static_assert(
         has_bounds_ == has_bounds, "Don't set SFINAE template parameter!");
-      static constexpr size_t REQUIRED_SIZE = required_size();
+      static constexpr size_t REQUIRED_SIZE = entries_size();
 
       // Allocate a power of two extra to allow the placement of the
       // pagemap be difficult to guess if randomize_position set.
@@ -182,7 +296,8 @@ namespace snmalloc
         randomize_position ? bits::next_pow2(REQUIRED_SIZE) * 4 : 0;
       size_t request_size = REQUIRED_SIZE + additional_size;
 
-      auto new_body_untyped = PAL::reserve(request_size);
+      // The bitmap of committed pages follows the pagemap.
+      auto new_body_untyped = PAL::reserve(request_size + committed_size());
 
       if (new_body_untyped == nullptr)
       {
@@ -229,6 +344,7 @@ namespace snmalloc
 
       body = new_body;
       body_opt = new_body;
+      committed = pointer_offset<uint64_t>(new_body_untyped, request_size);
     }
 
     template<bool has_bounds_ = has_bounds>
@@ -304,7 +420,7 @@ namespace snmalloc
       //  Note that: this means external pointer on Windows will be slow.
       if constexpr (potentially_out_of_range && !pal_supports<LazyCommit, PAL>)
       {
-        register_range(p, 1);
+        commit_entries(p, 1);
       }
 
       if constexpr (potentially_out_of_range)
@@ -18,7 +18,7 @@ namespace snmalloc
   template<class Object, void init(Object*) noexcept>
   class Singleton
   {
-    inline static FlagWord flag;
+    inline static FlagWord flag{"singleton"};
     inline static std::atomic<bool> initialised{false};
     inline static Object obj;
 
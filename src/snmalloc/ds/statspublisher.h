@@ -0,0 +1,75 @@
+#pragma once
+
+#include "../ds_core/ds_core.h"
+
+#include <atomic>
+#include <cstdint>
+
+namespace snmalloc
+{
+  /**
+   * Functions that publish or record allocator statistics, called
+   * periodically from the allocators' tickers.  One publisher can be
+   * registered for each `Slot`.  Until one is, the ticker pays a load of each
+   * slot on its slow path, and the allocation fast paths are unaffected.
+   */
+  class StatsPublisher
+  {
+  public:
+    using Publish = void (*)();
+
+    enum class Slot
+    {
+      /// Publication into shared memory, by `SharedStats`.
+      SharedStats,
+      /// Sampling into the ring of `HeapTimeline`.
+      HeapTimeline,
+      NumSlots
+    };
+
+  private:
+    static constexpr size_t NUM_SLOTS = static_cast<size_t>(Slot::NumSlots);
+
+    static inline std::atomic<Publish> publisher[NUM_SLOTS]{};
+
+    static inline std::atomic<uint64_t> interval_ms[NUM_SLOTS]{};
+
+    static inline std::atomic<uint64_t> last_publish_ms[NUM_SLOTS]{};
+
+  public:
+    /**
+     * Register `p` in `slot`, to be called at most once every `interval` ms.
+     * Passing `nullptr` stops publication.
+     */
+    static void set(Slot slot, Publish p, uint64_t interval)
+    {
+      auto i = static_cast<size_t>(slot);
+      interval_ms[i].store(interval, std::memory_order_relaxed);
+      publisher[i].store(p, std::memory_order_release);
+    }
+
+    /**
+     * Called periodically with the current time.  At most one caller per
+     * interval runs each publisher.
+     */
+    static void tick(uint64_t now_ms)
+    {
+      for (size_t i = 0; i < NUM_SLOTS; i++)
+      {
+        auto p = publisher[i].load(std::memory_order_acquire);
+        if (p == nullptr)
+          continue;
+
+        auto last = last_publish_ms[i].load(std::memory_order_relaxed);
+        if ((now_ms - last) < interval_ms[i].load(std::memory_order_relaxed))
+          continue;
+
+        if (!last_publish_ms[i].compare_exchange_strong(
+              last, now_ms, std::memory_order_relaxed))
+          continue;
+
+        p();
+      }
+    }
+  };
+} // namespace snmalloc
@@ -0,0 +1,39 @@
+#pragma once
+
+/**
+ * Static tracepoints on the allocator's slow paths, for tools such as
+ * bpftrace and perf that attach to them with uprobes.
+ *
+ * With `SNMALLOC_USDT` defined, each tracepoint is a USDT probe from
+ * `sys/sdt.h`, in the `snmalloc` provider.  A probe that no tracer is attached
+ * to is a single no-op instruction, so these can be left in production
+ * builds.  Otherwise, the tracepoints compile to nothing.
+ *
+ * The probes and their arguments are:
+ *
+ *  - `slab_acquire(slab, sizeclass)`: An allocator took a new slab.
+ *  - `slab_release(slab, sizeclass)`: An allocator returned a slab.
+ *  - `message_queue_drain(allocator)`: An allocator processed its queue of
+ *    remote deallocations.
+ *  - `remote_post(allocator, round)`: A round of posting the remote
+ *    deallocation cache.
+ *  - `buddy_refill(size)`: A buddy allocator refilled from its parent.
+ *  - `pal_commit(address, size)`: Memory was committed.
+ *  - `pal_decommit(address, size)`: Memory was decommitted.
+ */
+#if defined(SNMALLOC_USDT) && __has_include(<sys/sdt.h>)
+#  include <sys/sdt.h>
+
+#  define SNMALLOC_TRACEPOINT1(name, a) DTRACE_PROBE1(snmalloc, name, a)
+#  define SNMALLOC_TRACEPOINT2(name, a, b) \
+    DTRACE_PROBE2(snmalloc, name, a, b)
+#else
+#  define SNMALLOC_TRACEPOINT1(name, a) \
+    do \
+    { \
+    } while (0)
+#  define SNMALLOC_TRACEPOINT2(name, a, b) \
+    do \
+    { \
+    } while (0)
+#endif
@@ -0,0 +1,105 @@
+#pragma once
+#include "threadalloc.h"
+
+#include <atomic>
+
+namespace snmalloc
+{
+  /**
+   * A buffer through which one thread hands the objects that it frees to a
+   * helper thread, so that the freeing thread pays only for a store into a
+   * ring rather than for the deallocation itself.
+   *
+   * The freeing thread calls `dealloc`, and a helper thread provided by the
+   * program calls `drain` regularly.  The helper frees the objects with its
+   * own allocator, so objects owned by other allocators are sent back to
+   * their owners through the usual remote deallocation path, and are reused
+   * once the owner next handles its messages.  If the ring is full, `dealloc`
+   * frees the object directly.
+   *
+   * Each buffer has exactly one freeing thread and one helper thread, though
+   * a helper can drain many buffers.
+   *
+   * Destroying the buffer frees any objects left in it, on the destroying
+   * thread.  Both threads must have finished with the buffer first: a
+   * `drain` or `push` that races with the destructor is a use after free.
+   */
+  template<size_t Capacity = 1024>
+  class DeferredFree
+  {
+    static_assert(bits::is_pow2(Capacity), "Capacity must be a power of two");
+
+    /// Objects pushed in total.  Written only by the freeing thread.
+    alignas(CACHELINE_SIZE) std::atomic<size_t> tail{0};
+
+    /// The freeing thread's last view of `head`, so that it reads the
+    /// helper's cache line only when the ring appears full.
+    size_t cached_head{0};
+
+    /// Objects freed in total.  Written only by the helper thread.
+    alignas(CACHELINE_SIZE) std::atomic<size_t> head{0};
+
+    alignas(CACHELINE_SIZE) void* ring[Capacity];
+
+  public:
+    DeferredFree() = default;
+
+    DeferredFree(const DeferredFree&) = delete;
+    DeferredFree& operator=(const DeferredFree&) = delete;
+
+    ~DeferredFree()
+    {
+      drain();
+    }
+
+    /**
+     * Add `p` to the ring.  Called only by the freeing thread.  Returns
+     * false if the ring is full.
+     */
+    SNMALLOC_FAST_PATH bool push(void* p)
+    {
+      auto t = tail.load(std::memory_order_relaxed);
+      if (SNMALLOC_UNLIKELY(t - cached_head == Capacity))
+      {
+        cached_head = head.load(std::memory_order_acquire);
+        if (t - cached_head == Capacity)
+          return false;
+      }
+
+      ring[t % Capacity] = p;
+      tail.store(t + 1, std::memory_order_release);
+      return true;
+    }
+
+    /**
+     * Free `p` later, on the helper thread, or now if the ring is full.
+     * Called only by the freeing thread.
+     */
+    SNMALLOC_FAST_PATH void dealloc(void* p)
+    {
+      if (SNMALLOC_UNLIKELY(!push(p)))
+        ThreadAlloc::get().dealloc(p);
+    }
+
+    /**
+     * Free the objects in the ring, and send those owned by other
+     * allocators to their owners.  Called only by the helper thread.
+     * Returns the number of objects freed.
+     */
+    size_t drain()
+    {
+      auto h = head.load(std::memory_order_relaxed);
+      auto t = tail.load(std::memory_order_acquire);
+      if (h == t)
+        return 0;
+
+      auto& a = ThreadAlloc::get();
+      for (auto i = h; i != t; i++)
+        a.dealloc(ring[i % Capacity]);
+      head.store(t, std::memory_order_release);
+
+      a.post_remote();
+      return t - h;
+    }
+  };
+} // namespace snmalloc
@@ -1,4 +1,8 @@
 #include "bounds_checks.h"
+#include "deferredfree.h"
+#include "heaptimeline.h"
 #include "memcpy.h"
 #include "scopedalloc.h"
+#include "sharedstats.h"
+#include "statsreport.h"
 #include "threadalloc.h"
@@ -0,0 +1,243 @@
+#pragma once
+#include "statsreport.h"
+
+namespace snmalloc
+{
+  /**
+   * Formats in which a heap timeline can be written.
+   */
+  enum class TimelineFormat
+  {
+    /// One line per sample, after a line of column names.
+    Csv,
+    /// A single JSON object.
+    Json
+  };
+
+  /**
+   * The state of the allocator at one point in time.
+   */
+  struct TimelineSample
+  {
+    uint64_t time_ms;
+    uint64_t committed_bytes;
+    uint64_t large_bytes;
+    /// Bytes held free by each `BuddyLayer`.
+    uint64_t buddy_cached_bytes[NUM_BUDDY_LAYERS];
+    uint64_t allocators_with_pending_messages;
+    /// Bytes of slabs held for each small sizeclass.
+    uint64_t slab_bytes[NUM_SMALL_SIZECLASSES];
+  };
+
+  /**
+   * A timeline of the state of the allocator described by `Config`, kept in
+   * a ring of the most recent `CAPACITY` samples, so that spikes in memory
+   * usage can be related to the traffic that caused them after the fact.
+   *
+   * Once enabled, samples are taken from the allocators' tickers, which run
+   * on their slow paths, so there is no sampling thread and the fast paths
+   * are unaffected.  A process that is not allocating takes no samples,
+   * which the timestamps show.
+   */
+  template<SNMALLOC_CONCEPT(IsConfig) Config>
+  class HeapTimeline
+  {
+  public:
+    static constexpr size_t CAPACITY = 512;
+
+  private:
+    static inline TimelineSample samples[CAPACITY]{};
+
+    /// Samples taken in total, including any that were overwritten.
+    static inline std::atomic<uint64_t> taken{0};
+
+    /// Held while a sample is written into or copied out of the ring.
+    static inline std::atomic<bool> busy{false};
+
+    static bool try_acquire()
+    {
+      return !busy.load(std::memory_order_relaxed) &&
+        !busy.exchange(true, std::memory_order_acquire);
+    }
+
+    static void release()
+    {
+      busy.store(false, std::memory_order_release);
+    }
+
+    /**
+     * Copy sample `i` out of the ring.  Returns false if it has been
+     * overwritten.
+     */
+    static bool get(uint64_t i, TimelineSample& out)
+    {
+      while (!try_acquire())
+        Aal::pause();
+      bool present = taken.load(std::memory_order_relaxed) - i <= CAPACITY;
+      if (present)
+        out = samples[i % CAPACITY];
+      release();
+      return present;
+    }
+
+  public:
+    /**
+     * Take a sample every `interval_ms`, while the allocator is in use.
+     */
+    static void enable(uint64_t interval_ms)
+    {
+      record();
+      StatsPublisher::set(
+        StatsPublisher::Slot::HeapTimeline, &record, interval_ms);
+    }
+
+    /**
+     * Stop taking samples.  Those already taken are kept.
+     */
+    static void disable()
+    {
+      StatsPublisher::set(StatsPublisher::Slot::HeapTimeline, nullptr, 0);
+    }
+
+    /**
+     * Take a sample now.  This runs on the allocators' slow paths, so if
+     * another thread is using the ring, the sample is skipped rather than
+     * waiting for it.  This does not allocate.
+     */
+    static void record()
+    {
+      if (busy.load(std::memory_order_relaxed))
+        return;
+
+      StatsSnapshot s;
+      take_stats_snapshot<Config>(s);
+
+      TimelineSample t;
+      t.time_ms = Config::Pal::time_in_ms();
+      t.committed_bytes = s.current_memory_bytes;
+      t.large_bytes = s.large_bytes;
+      for (size_t i = 0; i < NUM_BUDDY_LAYERS; i++)
+        t.buddy_cached_bytes[i] =
+          BuddyCacheStats::get(static_cast<BuddyLayer>(i));
+      t.allocators_with_pending_messages = s.allocators_with_pending_messages;
+      for (smallsizeclass_t sizeclass = 0; sizeclass < NUM_SMALL_SIZECLASSES;
+           sizeclass++)
+        t.slab_bytes[sizeclass] =
+          s.slabs[sizeclass] * sizeclass_to_slab_size(sizeclass);
+
+      if (!try_acquire())
+        return;
+      auto n = taken.load(std::memory_order_relaxed);
+      samples[n % CAPACITY] = t;
+      taken.store(n + 1, std::memory_order_relaxed);
+      release();
+    }
+
+    /**
+     * The number of samples taken, including any that have been overwritten.
+     */
+    static uint64_t get_taken()
+    {
+      return taken.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Write the samples in the ring to `sink`, oldest first, in one or more
+     * pieces.  `sink` is called as `sink(const char* data, size_t length)`.
+     * Samples may be taken concurrently, in which case the oldest may be
+     * missing.  This does not allocate.
+     */
+    template<typename Sink>
+    static void write(TimelineFormat format, Sink& sink)
+    {
+      static constexpr const char* buddy_names[NUM_BUDDY_LAYERS] = {
+        "global_buddy_bytes", "local_buddy_bytes", "small_buddy_bytes"};
+
+      StatsWriter<Sink> w{sink};
+      bool json = format == TimelineFormat::Json;
+
+      if (json)
+      {
+        w.append("{\n  \"sizeclasses\": [");
+      }
+      else
+      {
+        w.append("time_ms,committed_bytes,large_bytes");
+        for (auto* name : buddy_names)
+        {
+          w.append(',');
+          w.append(name);
+        }
+        w.append(",allocators_with_pending_messages");
+      }
+      for (smallsizeclass_t sizeclass = 0; sizeclass < NUM_SMALL_SIZECLASSES;
+           sizeclass++)
+      {
+        if (json)
+        {
+          if (sizeclass != 0)
+            w.append(", ");
+        }
+        else
+        {
+          w.append(",slab_bytes_");
+        }
+        w.append_number(sizeclass_to_size(sizeclass));
+      }
+      w.append(json ? "],\n  \"samples\": [" : "\n");
+
+      // Writes a field of a sample.
+      auto field = [&](const char* name, uint64_t v, bool first) {
+        if (json)
+        {
+          w.append(first ? "{\"" : ", \"");
+          w.append(name);
+          w.append("\": ");
+        }
+        else if (!first)
+        {
+          w.append(',');
+        }
+        w.append_number(v);
+      };
+
+      auto end = taken.load(std::memory_order_relaxed);
+      auto start = end > CAPACITY ? end - CAPACITY : 0;
+      bool first = true;
+      for (auto i = start; i < end; i++)
+      {
+        TimelineSample t;
+        if (!get(i, t))
+          continue;
+
+        if (json)
+          w.append(first ? "\n    " : ",\n    ");
+        field("time_ms", t.time_ms, true);
+        field("committed_bytes", t.committed_bytes, false);
+        field("large_bytes", t.large_bytes, false);
+        for (size_t l = 0; l < NUM_BUDDY_LAYERS; l++)
+          field(buddy_names[l], t.buddy_cached_bytes[l], false);
+        field(
+          "allocators_with_pending_messages",
+          t.allocators_with_pending_messages,
+          false);
+        if (json)
+          w.append(", \"slab_bytes\": [");
+        for (smallsizeclass_t sizeclass = 0;
+             sizeclass < NUM_SMALL_SIZECLASSES;
+             sizeclass++)
+        {
+          if (json && (sizeclass != 0))
+            w.append(", ");
+          else if (!json)
+            w.append(',');
+          w.append_number(t.slab_bytes[sizeclass]);
+        }
+        w.append(json ? "]}" : "\n");
+        first = false;
+      }
+      if (json)
+        w.append(first ? "]\n}\n" : "\n  ]\n}\n");
+    }
+  };
+} // namespace snmalloc
@@ -0,0 +1,270 @@
+#pragma once
+#include "statsreport.h"
+
+#if defined(__linux__)
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <unistd.h>
+#endif
+
+namespace snmalloc
+{
+  /**
+   * The layout of a segment of shared memory into which a process publishes
+   * its allocator statistics, so that they can be observed by another process
+   * without disturbing the one being measured.
+   *
+   * The statistics are protected by a sequence lock: `sequence` is odd while
+   * they are being updated, and a reader retries if it changed during its
+   * copy.
+   */
+  struct SharedStatsSegment
+  {
+    /// "snmalloc", as a little-endian integer.
+    static constexpr uint64_t MAGIC = 0x636f6c6c616d6e73;
+
+    static constexpr uint32_t VERSION = 2;
+
+    uint64_t magic;
+    uint32_t version;
+    uint32_t size;
+    uint32_t num_sizeclasses;
+    uint32_t num_events;
+
+    std::atomic<uint64_t> sequence;
+
+    /// The time at which the statistics were last published, in ms.
+    uint64_t time_ms;
+
+    /// The object and slab sizes of each small sizeclass.
+    uint64_t sizeclass_sizes[NUM_SMALL_SIZECLASSES];
+    uint64_t slab_sizes[NUM_SMALL_SIZECLASSES];
+
+    StatsSnapshot stats;
+
+    static_assert(
+      std::atomic<uint64_t>::is_always_lock_free,
+      "The sequence is shared between processes, so must not use a lock");
+
+    /**
+     * Does this segment have the layout that this build expects?
+     */
+    bool is_compatible() const
+    {
+      return (magic == MAGIC) && (version == VERSION) &&
+        (size == sizeof(SharedStatsSegment)) &&
+        (num_sizeclasses == NUM_SMALL_SIZECLASSES) &&
+        (num_events == NUM_EVENTS);
+    }
+
+    /**
+     * Copy a consistent version of the statistics to `out`.  Returns false if
+     * none could be read because the writer kept updating them.
+     */
+    bool read(StatsSnapshot& out, uint64_t& out_time_ms) const
+    {
+      for (size_t i = 0; i < 1000; i++)
+      {
+        auto before = sequence.load(std::memory_order_acquire);
+        if ((before & 1) != 0)
+          continue;
+
+        out = stats;
+        out_time_ms = time_ms;
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence.load(std::memory_order_relaxed) == before)
+          return true;
+      }
+      return false;
+    }
+  };
+
+  /**
+   * Write `prefix` followed by the decimal `pid` into `path`.
+   */
+  inline void
+  shared_stats_format(char (&path)[64], const char* prefix, uint64_t pid)
+  {
+    size_t length = 0;
+    for (; prefix[length] != '\0'; length++)
+      path[length] = prefix[length];
+
+    char digits[20];
+    size_t count = 0;
+    do
+    {
+      digits[count++] = static_cast<char>('0' + (pid % 10));
+      pid /= 10;
+    } while (pid != 0);
+
+    while (count != 0)
+      path[length++] = digits[--count];
+    path[length] = '\0';
+  }
+
+  /**
+   * Write the POSIX shared memory name of the statistics segment of process
+   * `pid` into `name`, for use with `shm_open`.
+   */
+  inline void shared_stats_name(char (&name)[64], uint64_t pid)
+  {
+    shared_stats_format(name, "/snmalloc-stats-", pid);
+  }
+
+  /**
+   * Write the path of the statistics segment of process `pid` into `path`.
+   * This is where Linux exposes the shared memory object named by
+   * `shared_stats_name`.
+   */
+  inline void shared_stats_path(char (&path)[64], uint64_t pid)
+  {
+    shared_stats_format(path, "/dev/shm/snmalloc-stats-", pid);
+  }
+
+  /**
+   * Publication of the statistics of the allocator described by `Config`
+   * into a shared-memory segment, named by `shared_stats_name` for this
+   * process.  Once enabled, the statistics are updated from the allocators'
+   * tickers, which run on their slow paths, so the fast paths are unaffected.
+   * A process that is not allocating does not update its statistics; readers
+   * can detect this from the segment's timestamp.
+   *
+   * This is available only on Linux.
+   */
+  template<SNMALLOC_CONCEPT(IsConfig) Config>
+  class SharedStats
+  {
+    static inline std::atomic<SharedStatsSegment*> segment{nullptr};
+
+    /**
+     * Held while the segment is created, as creating it removes any other
+     * segment with its name.
+     */
+    static inline FlagWord create_lock{"shared_stats"};
+
+  public:
+    /**
+     * Create the segment, and publish the statistics into it at most once
+     * every `interval_ms`.  Returns false if the segment could not be
+     * created.
+     */
+    static bool enable(uint64_t interval_ms)
+    {
+#if defined(__linux__)
+      if (segment.load(std::memory_order_acquire) != nullptr)
+      {
+        StatsPublisher::set(
+          StatsPublisher::Slot::SharedStats, &publish, interval_ms);
+        return true;
+      }
+
+      FlagLock lock(create_lock);
+      if (segment.load(std::memory_order_acquire) != nullptr)
+      {
+        StatsPublisher::set(
+          StatsPublisher::Slot::SharedStats, &publish, interval_ms);
+        return true;
+      }
+
+      // The name is predictable, so remove any segment left by an earlier
+      // process with this pid, and then refuse to use anything that is
+      // created in its place before we create it ourselves.
+      char name[64];
+      shared_stats_name(name, static_cast<uint64_t>(getpid()));
+      shm_unlink(name);
+      int fd = shm_open(
+        name, O_RDWR | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, 0644);
+      if (fd < 0)
+        return false;
+
+      void* p = nullptr;
+      if (ftruncate(fd, sizeof(SharedStatsSegment)) == 0)
+      {
+        p = mmap(
+          nullptr,
+          sizeof(SharedStatsSegment),
+          PROT_READ | PROT_WRITE,
+          MAP_SHARED,
+          fd,
+          0);
+      }
+      ::close(fd);
+      if ((p == nullptr) || (p == MAP_FAILED))
+      {
+        shm_unlink(name);
+        return false;
+      }
+
+      // The file is zero filled, so the sequence is already valid.
+      auto* s = static_cast<SharedStatsSegment*>(p);
+      s->version = SharedStatsSegment::VERSION;
+      s->size = sizeof(SharedStatsSegment);
+      s->num_sizeclasses = NUM_SMALL_SIZECLASSES;
+      s->num_events = NUM_EVENTS;
+      for (smallsizeclass_t sizeclass = 0; sizeclass < NUM_SMALL_SIZECLASSES;
+           sizeclass++)
+      {
+        s->sizeclass_sizes[sizeclass] = sizeclass_to_size(sizeclass);
+        s->slab_sizes[sizeclass] = sizeclass_to_slab_size(sizeclass);
+      }
+
+      segment.store(s, std::memory_order_release);
+      publish();
+      // Written last, so that readers only see a complete header.
+      std::atomic_thread_fence(std::memory_order_release);
+      s->magic = SharedStatsSegment::MAGIC;
+
+      StatsPublisher::set(
+        StatsPublisher::Slot::SharedStats, &publish, interval_ms);
+      return true;
+#else
+      UNUSED(interval_ms);
+      return false;
+#endif
+    }
+
+    /**
+     * Update the statistics in the segment now.  If another thread is
+     * already updating them, this returns without waiting.
+     */
+    static void publish()
+    {
+      auto* s = segment.load(std::memory_order_acquire);
+      if (s == nullptr)
+        return;
+
+      auto seq = s->sequence.load(std::memory_order_relaxed);
+      if (
+        ((seq & 1) != 0) ||
+        !s->sequence.compare_exchange_strong(
+          seq, seq + 1, std::memory_order_acquire))
+        return;
+      std::atomic_thread_fence(std::memory_order_release);
+
+      StatsSnapshot stats;
+      take_stats_snapshot<Config>(stats);
+      s->stats = stats;
+      s->time_ms = Config::Pal::time_in_ms();
+
+      s->sequence.store(seq + 2, std::memory_order_release);
+    }
+
+    /**
+     * Stop publishing, and remove the segment's name.  The mapping is kept,
+     * as a publication may be in progress on another thread.
+     */
+    static void disable()
+    {
+#if defined(__linux__)
+      StatsPublisher::set(StatsPublisher::Slot::SharedStats, nullptr, 0);
+      if (segment.load(std::memory_order_acquire) == nullptr)
+        return;
+
+      char name[64];
+      shared_stats_name(name, static_cast<uint64_t>(getpid()));
+      shm_unlink(name);
+#endif
+    }
+  };
+} // namespace snmalloc
@@ -0,0 +1,449 @@
+#pragma once
+#include "../backend/globalconfig.h"
+
+namespace snmalloc
+{
+  /**
+   * Formats in which a statistics report can be produced.
+   */
+  enum class StatsFormat
+  {
+    /// A single JSON object.
+    Json,
+    /// The Prometheus text exposition format.
+    Prometheus
+  };
+
+  /**
+   * Buffers text in a fixed-size array, and passes it to `Sink` whenever the
+   * array fills and when the writer is flushed.  This does not allocate, so
+   * can be used to describe the heap from inside the allocator, including
+   * from a signal handler.
+   *
+   * `Sink` is called as `sink(const char* data, size_t length)`.
+   */
+  template<typename Sink>
+  class StatsWriter
+  {
+    Sink& sink;
+
+    char buffer[1024];
+
+    size_t length = 0;
+
+  public:
+    StatsWriter(Sink& sink) : sink(sink) {}
+
+    StatsWriter(const StatsWriter&) = delete;
+    StatsWriter& operator=(const StatsWriter&) = delete;
+
+    ~StatsWriter()
+    {
+      flush();
+    }
+
+    void flush()
+    {
+      if (length != 0)
+        sink(buffer, length);
+      length = 0;
+    }
+
+    void append(char c)
+    {
+      if (length == sizeof(buffer))
+        flush();
+      buffer[length++] = c;
+    }
+
+    void append(const char* s)
+    {
+      while (*s != '\0')
+        append(*s++);
+    }
+
+    /**
+     * Append `v` as a decimal number.
+     */
+    void append_number(uint64_t v)
+    {
+      char digits[20];
+      size_t count = 0;
+      do
+      {
+        digits[count++] = static_cast<char>('0' + (v % 10));
+        v /= 10;
+      } while (v != 0);
+
+      while (count != 0)
+        append(digits[--count]);
+    }
+  };
+
+  /**
+   * A copy of the statistics of an allocator, taken at one point in time.
+   * This is plain data, so can be copied into memory shared with another
+   * process.
+   */
+  struct StatsSnapshot
+  {
+    uint64_t current_memory_bytes;
+    uint64_t peak_memory_bytes;
+    uint64_t large_bytes;
+    uint64_t allocators;
+    uint64_t allocators_with_pending_messages;
+    uint64_t slabs[NUM_SMALL_SIZECLASSES];
+    uint64_t events[NUM_EVENTS];
+    uint64_t slab_metadata_bytes;
+    uint64_t allocator_metadata_bytes;
+    uint64_t pagemap_bytes;
+    /// One in this many allocations is sampled, or zero if none are.
+    uint64_t overhead_sample_interval;
+    /// Sampled sizes requested and rounded to, indexed by small sizeclass,
+    /// then `OverheadStats::LARGE`.
+    uint64_t sampled_requested[NUM_SMALL_SIZECLASSES + 1];
+    uint64_t sampled_rounded[NUM_SMALL_SIZECLASSES + 1];
+  };
+
+  /**
+   * Fill `s` with the statistics of the allocator described by `Config`:
+   * memory committed, slabs held for each sizeclass, large allocations,
+   * slow-path event counts, the allocators with unprocessed remote
+   * deallocations, and the overhead of rounding and metadata.  This does not
+   * allocate.
+   */
+  template<SNMALLOC_CONCEPT(IsConfig) Config>
+  void take_stats_snapshot(StatsSnapshot& s)
+  {
+    static_assert(
+      Config::Options.CoreAllocIsPoolAllocated,
+      "Statistics snapshots are available only for pool-allocated "
+      "configurations");
+
+    s.current_memory_bytes = Config::Backend::get_current_usage();
+    s.peak_memory_bytes = Config::Backend::get_peak_usage();
+    s.large_bytes = SizeclassStats::get_large_bytes();
+
+    s.allocators = 0;
+    s.allocators_with_pending_messages = 0;
+    auto* alloc = AllocPool<Config>::iterate();
+    while (alloc != nullptr)
+    {
+      s.allocators++;
+      if (alloc->has_pending_messages())
+        s.allocators_with_pending_messages++;
+      alloc = AllocPool<Config>::iterate(alloc);
+    }
+
+    for (smallsizeclass_t sizeclass = 0; sizeclass < NUM_SMALL_SIZECLASSES;
+         sizeclass++)
+      s.slabs[sizeclass] = SizeclassStats::get_slabs(sizeclass);
+
+    EventCounters events;
+    get_event_counters<Config>(events);
+    for (size_t i = 0; i < NUM_EVENTS; i++)
+      s.events[i] = events.get(static_cast<Event>(i));
+
+    s.slab_metadata_bytes = OverheadStats::get_slab_metadata();
+    s.allocator_metadata_bytes = OverheadStats::get_allocator_metadata();
+    s.pagemap_bytes = OverheadStats::get_pagemap();
+    s.overhead_sample_interval =
+      OverheadStatsEnabled ? OverheadStats::SAMPLE_INTERVAL : 0;
+    for (size_t i = 0; i <= OverheadStats::LARGE; i++)
+    {
+      s.sampled_requested[i] = OverheadStats::get_requested(i);
+      s.sampled_rounded[i] = OverheadStats::get_rounded(i);
+    }
+  }
+
+  /**
+   * Produces a report of the statistics gathered by `take_stats_snapshot`
+   * for the allocator described by `Config`, of sampled object lifetimes,
+   * and of lock contention.  The report is passed to `sink`, in one or more
+   * pieces, without allocating.
+   */
+  template<SNMALLOC_CONCEPT(IsConfig) Config, typename Sink>
+  void write_stats_report(StatsFormat format, Sink& sink)
+  {
+    StatsSnapshot s;
+    take_stats_snapshot<Config>(s);
+
+    StatsWriter<Sink> w{sink};
+    bool json = format == StatsFormat::Json;
+
+    // Writes a gauge, or a member of the top-level JSON object.
+    auto value = [&](const char* name, uint64_t v) {
+      if (json)
+      {
+        w.append("  \"");
+        w.append(name);
+        w.append("\": ");
+        w.append_number(v);
+        w.append(",\n");
+      }
+      else
+      {
+        w.append("# TYPE snmalloc_");
+        w.append(name);
+        w.append(" gauge\nsnmalloc_");
+        w.append(name);
+        w.append(' ');
+        w.append_number(v);
+        w.append('\n');
+      }
+    };
+
+    if (json)
+      w.append("{\n");
+    value("current_memory_bytes", s.current_memory_bytes);
+    value("peak_memory_bytes", s.peak_memory_bytes);
+    value("large_bytes", s.large_bytes);
+    value("allocators", s.allocators);
+    value(
+      "allocators_with_pending_messages", s.allocators_with_pending_messages);
+    value("slab_metadata_bytes", s.slab_metadata_bytes);
+    value("allocator_metadata_bytes", s.allocator_metadata_bytes);
+    value("pagemap_bytes", s.pagemap_bytes);
+    value("overhead_sample_interval", s.overhead_sample_interval);
+    value(
+      "lifetime_sample_interval",
+      LifetimeStatsEnabled ? LifetimeStats::SAMPLE_INTERVAL : 0);
+    value("lifetime_samples_dropped", LifetimeStats::get_dropped());
+    value(
+      "large_sampled_requested_bytes",
+      s.sampled_requested[OverheadStats::LARGE]);
+    value(
+      "large_sampled_rounded_bytes", s.sampled_rounded[OverheadStats::LARGE]);
+
+    // Per-sizeclass slabs and sampled rounding, only for sizeclasses that are
+    // in use or have been sampled.
+    if (json)
+      w.append("  \"sizeclasses\": [");
+    else
+      w.append("# TYPE snmalloc_sizeclass_slab_bytes gauge\n");
+    bool first = true;
+    for (smallsizeclass_t sizeclass = 0; sizeclass < NUM_SMALL_SIZECLASSES;
+         sizeclass++)
+    {
+      auto slabs = s.slabs[sizeclass];
+      if ((slabs == 0) && (s.sampled_requested[sizeclass] == 0))
+        continue;
+
+      auto size = sizeclass_to_size(sizeclass);
+      auto bytes = slabs * sizeclass_to_slab_size(sizeclass);
+      if (json)
+      {
+        w.append(first ? "\n" : ",\n");
+        w.append("    {\"size\": ");
+        w.append_number(size);
+        w.append(", \"slabs\": ");
+        w.append_number(slabs);
+        w.append(", \"bytes\": ");
+        w.append_number(bytes);
+        w.append(", \"sampled_requested_bytes\": ");
+        w.append_number(s.sampled_requested[sizeclass]);
+        w.append(", \"sampled_rounded_bytes\": ");
+        w.append_number(s.sampled_rounded[sizeclass]);
+        w.append('}');
+      }
+      else
+      {
+        w.append("snmalloc_sizeclass_slab_bytes{size=\"");
+        w.append_number(size);
+        w.append("\"} ");
+        w.append_number(bytes);
+        w.append('\n');
+      }
+      first = false;
+    }
+
+    // Prometheus groups samples by metric, so the sampled rounding of each
+    // sizeclass follows as separate metrics.
+    if (!json)
+    {
+      auto sampled_metric = [&](const char* metric, const uint64_t* bytes) {
+        w.append("# TYPE snmalloc_");
+        w.append(metric);
+        w.append(" counter\n");
+        for (size_t i = 0; i < NUM_SMALL_SIZECLASSES; i++)
+        {
+          if (s.sampled_requested[i] == 0)
+            continue;
+          w.append("snmalloc_");
+          w.append(metric);
+          w.append("{size=\"");
+          w.append_number(sizeclass_to_size(i));
+          w.append("\"} ");
+          w.append_number(bytes[i]);
+          w.append('\n');
+        }
+      };
+      sampled_metric("sizeclass_sampled_requested_bytes", s.sampled_requested);
+      sampled_metric("sizeclass_sampled_rounded_bytes", s.sampled_rounded);
+    }
+
+    if (json)
+      w.append(first ? "],\n  \"events\": {" : "\n  ],\n  \"events\": {");
+    else
+      w.append("# TYPE snmalloc_events_total counter\n");
+    for (size_t i = 0; i < NUM_EVENTS; i++)
+    {
+      auto count = s.events[i];
+      if (json)
+      {
+        w.append(i == 0 ? "\n    \"" : ",\n    \"");
+        w.append(event_names[i]);
+        w.append("\": ");
+        w.append_number(count);
+      }
+      else
+      {
+        w.append("snmalloc_events_total{event=\"");
+        w.append(event_names[i]);
+        w.append("\"} ");
+        w.append_number(count);
+        w.append('\n');
+      }
+    }
+
+    // Histograms of sampled lifetimes, in ticks, for each sizeclass with
+    // samples, if lifetime statistics are enabled.  Large allocations are
+    // reported together.  JSON gives the count in each log2 bucket, up to
+    // the last that is not empty; Prometheus gives cumulative buckets.
+    if (json)
+      w.append("\n  },\n  \"lifetimes\": [");
+    else
+      w.append("# TYPE snmalloc_object_lifetime_ticks histogram\n");
+    first = true;
+    for (size_t i = 0; i <= LifetimeStats::LARGE; i++)
+    {
+      size_t buckets = 0;
+      uint64_t count = 0;
+      for (size_t b = 0; b < LifetimeStats::BUCKETS; b++)
+      {
+        auto c = LifetimeStats::get_count(i, b);
+        count += c;
+        if (c != 0)
+          buckets = b + 1;
+      }
+      if (count == 0)
+        continue;
+
+      if (json)
+      {
+        w.append(first ? "\n    {" : ",\n    {");
+        if (i == LifetimeStats::LARGE)
+        {
+          w.append("\"large\": true");
+        }
+        else
+        {
+          w.append("\"size\": ");
+          w.append_number(sizeclass_to_size(i));
+        }
+        w.append(", \"count\": ");
+        w.append_number(count);
+        w.append(", \"sum\": ");
+        w.append_number(LifetimeStats::get_sum(i));
+        w.append(", \"buckets\": [");
+        for (size_t b = 0; b < buckets; b++)
+        {
+          if (b != 0)
+            w.append(", ");
+          w.append_number(LifetimeStats::get_count(i, b));
+        }
+        w.append("]}");
+      }
+      else
+      {
+        auto label = [&]() {
+          w.append("{size=\"");
+          if (i == LifetimeStats::LARGE)
+            w.append("large");
+          else
+            w.append_number(sizeclass_to_size(i));
+          w.append('"');
+        };
+        uint64_t cumulative = 0;
+        for (size_t b = 0; b < buckets; b++)
+        {
+          cumulative += LifetimeStats::get_count(i, b);
+          w.append("snmalloc_object_lifetime_ticks_bucket");
+          label();
+          w.append(",le=\"");
+          w.append_number(UINT64_MAX >> (63 - b));
+          w.append("\"} ");
+          w.append_number(cumulative);
+          w.append('\n');
+        }
+        w.append("snmalloc_object_lifetime_ticks_bucket");
+        label();
+        w.append(",le=\"+Inf\"} ");
+        w.append_number(count);
+        w.append("\nsnmalloc_object_lifetime_ticks_sum");
+        label();
+        w.append("} ");
+        w.append_number(LifetimeStats::get_sum(i));
+        w.append("\nsnmalloc_object_lifetime_ticks_count");
+        label();
+        w.append("} ");
+        w.append_number(count);
+        w.append('\n');
+      }
+      first = false;
+    }
+
+    // Contention of each lock that has been acquired, if lock statistics are
+    // enabled.  Locks that share a name are told apart by their position in
+    // the list.
+    if (json)
+    {
+      w.append(first ? "],\n  \"locks\": [" : "\n  ],\n  \"locks\": [");
+      for (auto* l = LockStats::iterate(); l != nullptr;
+           l = LockStats::iterate(l))
+      {
+        w.append(l == LockStats::iterate() ? "\n" : ",\n");
+        w.append("    {\"name\": \"");
+        w.append(l->get_name());
+        w.append("\", \"acquisitions\": ");
+        w.append_number(l->get_acquisitions());
+        w.append(", \"contended\": ");
+        w.append_number(l->get_contended());
+        w.append(", \"spins\": ");
+        w.append_number(l->get_spins());
+        w.append('}');
+      }
+      w.append(LockStats::iterate() == nullptr ? "]\n}\n" : "\n  ]\n}\n");
+    }
+    else
+    {
+      auto lock_metric = [&](const char* metric, auto get) {
+        w.append("# TYPE snmalloc_lock_");
+        w.append(metric);
+        w.append(" counter\n");
+        size_t instance = 0;
+        for (auto* l = LockStats::iterate(); l != nullptr;
+             l = LockStats::iterate(l))
+        {
+          w.append("snmalloc_lock_");
+          w.append(metric);
+          w.append("{lock=\"");
+          w.append(l->get_name());
+          w.append("\",instance=\"");
+          w.append_number(instance++);
+          w.append("\"} ");
+          w.append_number(get(l));
+          w.append('\n');
+        }
+      };
+      lock_metric("acquisitions_total", [](const LockStats* l) {
+        return l->get_acquisitions();
+      });
+      lock_metric("contended_total", [](const LockStats* l) {
+        return l->get_contended();
+      });
+      lock_metric(
+        "spins_total", [](const LockStats* l) { return l->get_spins(); });
+    }
+  }
+} // namespace snmalloc
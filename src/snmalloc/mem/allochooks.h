@@ -0,0 +1,152 @@
+#pragma once
+
+#include "../ds/ds.h"
+
+#include <atomic>
+
+namespace snmalloc
+{
+  /**
+   * Are small allocations and deallocations sampled for the allocation
+   * hooks?  This adds a countdown to the allocation and deallocation fast
+   * paths, so is off by default.  Define `SNMALLOC_ALLOC_HOOK_SAMPLING` to
+   * enable it.  Without it, hooks only see events on the slow paths.
+   */
+#if defined(SNMALLOC_ALLOC_HOOK_SAMPLING) && !defined(SNMALLOC_PASS_THROUGH)
+  static constexpr bool AllocHookSamplingEnabled = true;
+#else
+  static constexpr bool AllocHookSamplingEnabled = false;
+#endif
+
+  /**
+   * Callbacks for allocation events, for profilers.  Any of them may be null.
+   */
+  struct AllocHookTable
+  {
+    /// An object of `size` bytes was allocated at `p`.
+    void (*on_alloc)(void* p, size_t size);
+    /// The object at `p`, of usable size `size`, was deallocated.
+    void (*on_dealloc)(void* p, size_t size);
+    /// `realloc` moved the object at `old_p` to `new_p`, now `size` bytes.
+    void (*on_realloc)(void* old_p, void* new_p, size_t size);
+    /// Report one in this many small events, or none if zero.
+    size_t sample_interval;
+  };
+
+  /**
+   * Process-wide hooks, called on allocation events so that a profiler can
+   * observe them without interposing on `malloc`.
+   *
+   * Large allocations and deallocations, and `realloc`s that move their
+   * object, are always reported.  These are on the slow paths, where a
+   * single branch on `active` is all that hooks cost while none are set.
+   * Large objects freed by another thread are reported when the allocating
+   * thread returns their memory.
+   *
+   * Small objects are reported only if snmalloc is built with
+   * `SNMALLOC_ALLOC_HOOK_SAMPLING`, in which case each thread reports one in
+   * `sample_interval` of its small allocations and, separately, of its small
+   * deallocations.
+   *
+   * A hook that allocates or frees does not cause further hooks to be called
+   * on its thread.
+   */
+  class AllocHooks
+  {
+    static inline std::atomic<bool> enabled{false};
+    static inline std::atomic<void (*)(void*, size_t)> alloc_hook{nullptr};
+    static inline std::atomic<void (*)(void*, size_t)> dealloc_hook{nullptr};
+    static inline std::atomic<void (*)(void*, void*, size_t)> realloc_hook{
+      nullptr};
+    static inline std::atomic<size_t> interval{0};
+
+    static bool& in_hook()
+    {
+      static thread_local bool running = false;
+      return running;
+    }
+
+    template<typename Hook, typename... Args>
+    static void call(Hook hook, Args... args)
+    {
+      auto& running = in_hook();
+      if ((hook == nullptr) || running)
+        return;
+      running = true;
+      hook(args...);
+      running = false;
+    }
+
+  public:
+    /**
+     * Countdown used by threads while no sampling is configured, so that
+     * they notice a new configuration within this many events.
+     */
+    static constexpr size_t IDLE_INTERVAL = bits::one_at_bit(12);
+
+    /**
+     * Replace the hooks with those in `table`, which is copied.  Threads may
+     * briefly call a mixture of the old and new hooks.
+     */
+    static void set(const AllocHookTable& table)
+    {
+      alloc_hook.store(table.on_alloc, std::memory_order_relaxed);
+      dealloc_hook.store(table.on_dealloc, std::memory_order_relaxed);
+      realloc_hook.store(table.on_realloc, std::memory_order_relaxed);
+      interval.store(table.sample_interval, std::memory_order_relaxed);
+      enabled.store(
+        (table.on_alloc != nullptr) || (table.on_dealloc != nullptr) ||
+          (table.on_realloc != nullptr),
+        std::memory_order_release);
+    }
+
+    /**
+     * Remove all hooks.
+     */
+    static void clear()
+    {
+      set({nullptr, nullptr, nullptr, 0});
+    }
+
+    /**
+     * Are any hooks set?  Callers test this before reporting an event.
+     */
+    static SNMALLOC_FAST_PATH bool active()
+    {
+      return enabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * The countdown to the next sampled small event.
+     */
+    static size_t sample_interval()
+    {
+      auto i = interval.load(std::memory_order_relaxed);
+      return (active() && (i != 0)) ? i : IDLE_INTERVAL;
+    }
+
+    /**
+     * Is the current countdown reporting events, rather than idling?
+     */
+    static bool sampling()
+    {
+      return active() && (interval.load(std::memory_order_relaxed) != 0);
+    }
+
+    static SNMALLOC_SLOW_PATH void alloc(void* p, size_t size)
+    {
+      call(alloc_hook.load(std::memory_order_acquire), p, size);
+    }
+
+    static SNMALLOC_SLOW_PATH void dealloc(void* p, size_t size)
+    {
+      call(dealloc_hook.load(std::memory_order_acquire), p, size);
+    }
+
+    static SNMALLOC_SLOW_PATH void
+    realloc(void* old_p, void* new_p, size_t size)
+    {
+      call(realloc_hook.load(std::memory_order_acquire), old_p, new_p, size);
+    }
+  };
+} // namespace snmalloc
@@ -0,0 +1,64 @@
+#pragma once
+
+#include "../ds/ds.h"
+
+#include <atomic>
+#include <cstdint>
+
+namespace snmalloc
+{
+  /**
+   * Tag used to attribute memory to the part of a program that allocated it.
+   * Each thread has a current tag, which is zero unless it has been set.
+   */
+  using alloc_tag_t = uint8_t;
+
+  /**
+   * Live bytes attributed to a single tag.  Threads working under different
+   * tags update different counters, so each is on its own cache line.
+   */
+  struct alignas(CACHELINE_SIZE) AllocTagCounter
+  {
+    std::atomic<size_t> bytes{0};
+  };
+
+  /**
+   * Live bytes attributed to each allocation tag.
+   *
+   * Memory is accounted when an allocator acquires a slab or large chunk from
+   * the backend, to the current tag of the thread that acquired it, and
+   * removed when the slab or chunk is returned.  Objects are not accounted
+   * individually, so a slab shared by objects allocated under several tags is
+   * attributed entirely to the tag that was current when it was acquired, and
+   * memory cached in the slabs of an allocator remains attributed until the
+   * slabs are returned.
+   */
+  class AllocTags
+  {
+  public:
+    static constexpr size_t NUM_TAGS =
+      bits::one_at_bit(sizeof(alloc_tag_t) * 8);
+
+  private:
+    static inline AllocTagCounter live[NUM_TAGS]{};
+
+  public:
+    static void add(alloc_tag_t tag, size_t size)
+    {
+      live[tag].bytes.fetch_add(size, std::memory_order_relaxed);
+    }
+
+    static void remove(alloc_tag_t tag, size_t size)
+    {
+      live[tag].bytes.fetch_sub(size, std::memory_order_relaxed);
+    }
+
+    /**
+     * Bytes of slabs and large chunks currently attributed to `tag`.
+     */
+    static size_t get_live(alloc_tag_t tag)
+    {
+      return live[tag].bytes.load(std::memory_order_relaxed);
+    }
+  };
+} // namespace snmalloc
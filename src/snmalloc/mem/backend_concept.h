@@ -117,6 +117,11 @@ namespace snmalloc
         Backend::dealloc_chunk(local_state, slab_metadata, alloc, size)
         } -> ConceptSame<void>;
     } &&
+    requires(LocalState& local_state) {
+      {
+        Backend::purge(local_state)
+        } -> ConceptSame<void>;
+    } &&
     requires(address_t p) {
       {
         Backend::template get_metaentry<true>(p)
@@ -33,6 +33,25 @@ namespace snmalloc
     return true;
   }
 
+  /**
+   * SFINAE helper.  Matched only if `T` implements `ensure_init`.  Calls it
+   * if it exists.
+   */
+  template<typename T>
+  SNMALLOC_FAST_PATH_INLINE auto call_ensure_init(T*, int)
+    -> decltype(T::ensure_init())
+  {
+    T::ensure_init();
+  }
+
+  /**
+   * SFINAE helper.  Matched only if `T` does not implement `ensure_init`.
+   * Does nothing if called.
+   */
+  template<typename T>
+  SNMALLOC_FAST_PATH_INLINE auto call_ensure_init(T*, long)
+  {}
+
   namespace detail
   {
     /**
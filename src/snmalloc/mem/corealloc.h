@@ -1,10 +1,13 @@
 #pragma once
 
 #include "../ds/ds.h"
+#include "allochooks.h"
 #include "localcache.h"
 #include "metadata.h"
+#include "overheadstats.h"
 #include "pool.h"
 #include "remotecache.h"
+#include "sizeclassstats.h"
 #include "sizeclasstable.h"
 #include "ticker.h"
 
@@ -59,6 +62,12 @@ namespace snmalloc
 
       uint16_t unused = 0;
       uint16_t length = 0;
+
+      /**
+       * Number of unused slabs that are kept rather than returned to the
+       * backend, set by `reserve_slabs`.
+       */
+      uint16_t reserved = 0;
     } alloc_classes[NUM_SMALL_SIZECLASSES]{};
 
     /**
@@ -111,6 +120,27 @@ namespace snmalloc
      */
     Ticker<typename Config::Pal> ticker;
 
+    /**
+     * The `MemoryPressure` epoch when this allocator last returned its cached
+     * memory.  Another thread that runs out of memory cannot reach this
+     * allocator's caches, so it advances the epoch, and this allocator
+     * returns them on its next allocation slow path.
+     */
+    size_t purge_epoch{MemoryPressure::get_epoch()};
+
+    /**
+     * Counts of the slow paths taken by this allocator, and of the backend
+     * events on its behalf.  Empty unless `EventCountersEnabled`.
+     */
+    SNMALLOC_NO_UNIQUE_ADDRESS EventCountersField events;
+
+    /**
+     * The address of the last message in the message queue when it was last
+     * found to be drained.  Written only by the owning thread, but read by
+     * `has_pending_messages` from any thread.
+     */
+    std::atomic<address_t> handled_back{0};
+
     /**
      * The message queue needs to be accessible from other threads
      *
@@ -175,6 +205,8 @@ namespace snmalloc
     void init_message_queue()
     {
       message_queue().init();
+      handled_back.store(
+        message_queue().back_address(), std::memory_order_relaxed);
     }
 
     static SNMALLOC_FAST_PATH void alloc_new_list(
@@ -325,12 +357,16 @@ namespace snmalloc
         start_of_slab.unsafe_ptr(),
         sizeclass);
 #endif
+      EventLog::record(
+        LogEvent::SlabUnused, address_cast(start_of_slab), sizeclass);
       return start_of_slab;
     }
 
     template<bool check_slabs = false>
     SNMALLOC_SLOW_PATH void dealloc_local_slabs(smallsizeclass_t sizeclass)
     {
+      BackendEventScope backend_events(events);
+
       // Return unused slabs of sizeclass_t back to global allocator
       alloc_classes[sizeclass].available.iterate([this, sizeclass](auto* meta) {
         auto domesticate =
@@ -353,6 +389,11 @@ namespace snmalloc
           return;
         }
 
+        // Keep the slabs that have been explicitly reserved.
+        if (
+          alloc_classes[sizeclass].unused <= alloc_classes[sizeclass].reserved)
+          return;
+
         alloc_classes[sizeclass].length--;
         alloc_classes[sizeclass].unused--;
 
@@ -364,6 +405,9 @@ namespace snmalloc
         // don't touch the cache lines at this point in snmalloc_check_client.
         auto start = clear_slab(meta, sizeclass);
 
+        meta->untag(sizeclass_to_slab_size(sizeclass));
+        SizeclassStats::remove_slab(sizeclass);
+        SNMALLOC_TRACEPOINT2(slab_release, address_cast(start), sizeclass);
         Config::Backend::dealloc_chunk(
           get_backend_local_state(),
           *meta,
@@ -382,6 +426,8 @@ namespace snmalloc
     dealloc_local_object_slow(capptr::Alloc<void> p, const PagemapEntry& entry)
     {
       // TODO: Handle message queue on this path?
+      events.count(Event::DeallocLocalSlow);
+      BackendEventScope backend_events(events);
 
       auto* meta = entry.get_slab_metadata();
 
@@ -393,13 +439,16 @@ namespace snmalloc
 
 #ifdef SNMALLOC_TRACING
         message<1024>("Large deallocation: {}", size);
-#else
-        UNUSED(size);
 #endif
+        EventLog::record(LogEvent::LargeDealloc, address_cast(p), size);
+        if (SNMALLOC_UNLIKELY(AllocHooks::active()))
+          AllocHooks::dealloc(p.unsafe_ptr(), size);
 
         // Remove from set of fully used slabs.
         meta->node.remove();
 
+        meta->untag(size);
+        SizeclassStats::remove_large(size);
         Config::Backend::dealloc_chunk(
           get_backend_local_state(), *meta, p, size);
 
@@ -425,6 +474,7 @@ namespace snmalloc
 #ifdef SNMALLOC_TRACING
         message<1024>("Slab is woken up");
 #endif
+        EventLog::record(LogEvent::SlabWake, address_cast(p), sizeclass);
 
         ticker.check_tick();
         return;
@@ -432,10 +482,12 @@ namespace snmalloc
 
       alloc_classes[sizeclass].unused++;
 
-      // If we have several slabs, and it isn't too expensive as a proportion
-      // return to the global pool.
+      // If we have several slabs beyond those reserved, and it isn't too
+      // expensive as a proportion return to the global pool.  Fewer spare
+      // slabs are kept when the memory budget is constrained.
       if (
-        (alloc_classes[sizeclass].unused > 2) &&
+        (alloc_classes[sizeclass].unused >
+         alloc_classes[sizeclass].reserved + MemoryBudget::spare_slabs()) &&
         (alloc_classes[sizeclass].unused >
          (alloc_classes[sizeclass].length >> 2)))
       {
@@ -478,6 +530,8 @@ namespace snmalloc
     SNMALLOC_SLOW_PATH decltype(auto)
     handle_message_queue_inner(Action action, Args... args)
     {
+      events.count(Event::MessageQueue);
+      SNMALLOC_TRACEPOINT1(message_queue_drain, address_cast(this));
       bool need_post = false;
       auto local_state = backend_state_ptr();
       auto domesticate = [local_state](freelist::QueuePtr p)
@@ -489,6 +543,7 @@ namespace snmalloc
 #ifdef SNMALLOC_TRACING
         message<1024>("Handling remote");
 #endif
+        EventLog::record(LogEvent::HandleRemote, address_cast(this));
 
         auto& entry =
           Config::Backend::template get_metaentry(snmalloc::address_cast(msg));
@@ -515,6 +570,12 @@ namespace snmalloc
         message_queue().dequeue(domesticate, domesticate, cb);
       }
 
+      // Everything up to the last message, which the queue holds until
+      // another arrives, has been handled.
+      if (!has_messages())
+        handled_back.store(
+          message_queue().front_address(), std::memory_order_relaxed);
+
       if (need_post)
       {
         post();
@@ -548,13 +609,12 @@ namespace snmalloc
       }
       else
       {
-        if (
-          !need_post &&
-          !attached_cache->remote_dealloc_cache.reserve_space(entry))
+        auto& cache = attached_cache->remote_dealloc_cache;
+        cache.ensure_init();
+        if (!need_post && !cache.reserve_space(entry))
           need_post = true;
-        attached_cache->remote_dealloc_cache
-          .template dealloc<sizeof(CoreAllocator)>(
-            entry.get_remote()->trunc_id(), p.as_void());
+        cache.template dealloc<sizeof(CoreAllocator)>(
+          entry.get_remote()->trunc_id(), p.as_void());
       }
     }
 
@@ -570,6 +630,7 @@ namespace snmalloc
 #ifdef SNMALLOC_TRACING
       message<1024>("Making an allocator.");
 #endif
+      EventLog::record(LogEvent::MakeAllocator, address_cast(this));
       // Entropy must be first, so that all data-structures can use the key
       // it generates.
       // This must occur before any freelists are constructed.
@@ -600,19 +661,33 @@ namespace snmalloc
 
       if constexpr (DEBUG)
       {
-        for (smallsizeclass_t i = 0; i < NUM_SMALL_SIZECLASSES; i++)
-        {
-          size_t size = sizeclass_to_size(i);
-          smallsizeclass_t sc1 = size_to_sizeclass(size);
-          smallsizeclass_t sc2 = size_to_sizeclass_const(size);
-          size_t size1 = sizeclass_to_size(sc1);
-          size_t size2 = sizeclass_to_size(sc2);
-
-          SNMALLOC_CHECK(sc1 == i);
-          SNMALLOC_CHECK(sc1 == sc2);
-          SNMALLOC_CHECK(size1 == size);
-          SNMALLOC_CHECK(size1 == size2);
-        }
+        check_sizeclass_table();
+      }
+    }
+
+    /**
+     * Checks the sizeclass table is consistent.  The table is global, so this
+     * is only run by the first allocator to be constructed rather than adding
+     * a walk over every sizeclass to the construction of each allocator.
+     */
+    static void check_sizeclass_table()
+    {
+      static std::atomic<bool> checked{false};
+      if (checked.exchange(true, std::memory_order_relaxed))
+        return;
+
+      for (smallsizeclass_t i = 0; i < NUM_SMALL_SIZECLASSES; i++)
+      {
+        size_t size = sizeclass_to_size(i);
+        smallsizeclass_t sc1 = size_to_sizeclass(size);
+        smallsizeclass_t sc2 = size_to_sizeclass_const(size);
+        size_t size1 = sizeclass_to_size(sc1);
+        size_t size2 = sizeclass_to_size(sc2);
+
+        SNMALLOC_CHECK(sc1 == i);
+        SNMALLOC_CHECK(sc1 == sc2);
+        SNMALLOC_CHECK(size1 == size);
+        SNMALLOC_CHECK(size1 == size2);
       }
     }
 
@@ -671,11 +746,10 @@ namespace snmalloc
      */
     SNMALLOC_FAST_PATH bool post()
     {
-      // stats().remote_post();  // TODO queue not in line!
       bool sent_something =
         attached_cache->remote_dealloc_cache
           .post<sizeof(CoreAllocator), Config>(
-            backend_state_ptr(), public_state()->trunc_id());
+            backend_state_ptr(), public_state()->trunc_id(), events);
 
       return sent_something;
     }
@@ -684,13 +758,23 @@ namespace snmalloc
     SNMALLOC_FAST_PATH decltype(auto)
     handle_message_queue(Action action, Args... args)
     {
-      // Inline the empty check, but not necessarily the full queue handling.
-      if (SNMALLOC_LIKELY(!has_messages()))
+      // A single-threaded allocator only receives messages from other
+      // allocators on the same thread, so leaves them until it is flushed.
+      if constexpr (Config::Options.IsSingleThreaded)
       {
         return action(args...);
       }
+      else
+      {
+        // Inline the empty check, but not necessarily the full queue
+        // handling.
+        if (SNMALLOC_LIKELY(!has_messages()))
+        {
+          return action(args...);
+        }
 
-      return handle_message_queue_inner(action, args...);
+        return handle_message_queue_inner(action, args...);
+      }
     }
 
     SNMALLOC_FAST_PATH void
@@ -734,6 +818,8 @@ namespace snmalloc
     SNMALLOC_SLOW_PATH capptr::Alloc<void>
     small_alloc(smallsizeclass_t sizeclass, freelist::Iter<>& fast_free_list)
     {
+      check_memory_pressure();
+
       // Look to see if we can grab a free list.
       auto& sl = alloc_classes[sizeclass].available;
       if (SNMALLOC_LIKELY(alloc_classes[sizeclass].length > 0))
@@ -800,6 +886,8 @@ namespace snmalloc
     SNMALLOC_SLOW_PATH capptr::Alloc<void> small_alloc_slow(
       smallsizeclass_t sizeclass, freelist::Iter<>& fast_free_list)
     {
+      events.count(Event::SmallAllocSlow);
+      BackendEventScope backend_events(events);
       size_t rsize = sizeclass_to_size(sizeclass);
 
       // No existing free list get a new slab.
@@ -808,6 +896,7 @@ namespace snmalloc
 #ifdef SNMALLOC_TRACING
       message<1024>("small_alloc_slow rsize={} slab size={}", rsize, slab_size);
 #endif
+      EventLog::record(LogEvent::SmallAllocSlow, rsize, slab_size);
 
       auto [slab, meta] = Config::Backend::alloc_chunk(
         get_backend_local_state(),
@@ -823,6 +912,9 @@ namespace snmalloc
       // Set meta slab to empty.
       meta->initialise(
         sizeclass, address_cast(slab), entropy.get_free_list_key());
+      meta->set_tag(attached_cache->tag, slab_size);
+      SizeclassStats::add_slab(sizeclass);
+      SNMALLOC_TRACEPOINT2(slab_acquire, address_cast(slab), sizeclass);
 
       // Build a free list for the slab
       alloc_new_list(slab, meta, rsize, slab_size, entropy);
@@ -848,6 +940,124 @@ namespace snmalloc
       return ticker.check_tick(r);
     }
 
+    /**
+     * Add new slabs to the available set for `sizeclass`, until at least
+     * `count` objects can be allocated from unused slabs.  The slabs are
+     * faulted in, and pinned if `pin` is set, and are kept by this allocator
+     * until it is flushed, rather than being returned to the backend when
+     * they become unused.
+     *
+     * Returns false if the backend could not provide a slab, or if pinning
+     * was requested and failed.
+     */
+    bool reserve_slabs(smallsizeclass_t sizeclass, size_t count, bool pin)
+    {
+      BackendEventScope backend_events(events);
+      auto& cache = alloc_classes[sizeclass];
+      size_t rsize = sizeclass_to_size(sizeclass);
+      size_t slab_size = sizeclass_to_slab_size(sizeclass);
+      uint16_t objects = sizeclass_to_slab_object_count(sizeclass);
+      size_t slabs = bits::min<size_t>(
+        (count + objects - 1) / objects, UINT16_MAX - cache.length);
+
+      cache.reserved = bits::max(cache.reserved, static_cast<uint16_t>(slabs));
+
+      bool result = true;
+      for (size_t i = cache.unused; i < slabs; i++)
+      {
+        auto [slab, meta] = Config::Backend::alloc_chunk(
+          get_backend_local_state(),
+          slab_size,
+          PagemapEntry::encode(
+            public_state(), sizeclass_t::from_small_class(sizeclass)));
+
+        if (slab == nullptr)
+          return false;
+
+        result &= pal_prefault<typename Config::Pal>(
+          slab.unsafe_ptr(), slab_size, pin);
+
+        meta->initialise(
+          sizeclass, address_cast(slab), entropy.get_free_list_key());
+        meta->set_tag(attached_cache->tag, slab_size);
+        SizeclassStats::add_slab(sizeclass);
+        SNMALLOC_TRACEPOINT2(slab_acquire, address_cast(slab), sizeclass);
+        alloc_new_list(slab, meta, rsize, slab_size, entropy);
+
+        // Every object is on the free queue, so this marks the slab unused.
+        meta->set_sleeping(sizeclass, objects);
+
+        cache.available.insert(meta);
+        cache.length++;
+        cache.unused++;
+      }
+
+#ifdef SNMALLOC_TRACING
+      message<1024>(
+        "reserve_slabs sizeclass={} slabs={} unused={}",
+        sizeclass,
+        slabs,
+        cache.unused);
+#endif
+      return result;
+    }
+
+    /**
+     * Fault in `count` chunks for large allocations of `size` bytes, and
+     * return them to the backend, so that they are held in its thread-local
+     * caches, as far as their capacity allows.  The chunks go straight to the
+     * backend, so no allocation is recorded by the frontend statistics or
+     * hooks.
+     *
+     * Returns false if the backend could not provide a chunk, or if pinning
+     * was requested and failed.
+     */
+    bool reserve_chunks(size_t size, size_t count, bool pin)
+    {
+      BackendEventScope backend_events(events);
+      size_t chunk_size = large_size_to_chunk_size(size);
+
+      // Thread the chunks together through their first word, so that they can
+      // all be held before any are returned.
+      bool result = true;
+      void* chunks = nullptr;
+      for (size_t i = 0; i < count; i++)
+      {
+        auto [chunk, meta] = Config::Backend::alloc_chunk(
+          get_backend_local_state(),
+          chunk_size,
+          PagemapEntry::encode(public_state(), size_to_sizeclass_full(size)));
+
+        if (chunk == nullptr)
+        {
+          result = false;
+          break;
+        }
+
+        result &= pal_prefault<typename Config::Pal>(
+          chunk.unsafe_ptr(), chunk_size, pin);
+        *chunk.template as_static<void*>().unsafe_ptr() = chunks;
+        chunks = chunk.unsafe_ptr();
+      }
+
+      while (chunks != nullptr)
+      {
+        void* next = *static_cast<void**>(chunks);
+        auto p = capptr::Alloc<void>::unsafe_from(chunks);
+        auto* meta =
+          Config::Backend::get_metaentry(address_cast(p)).get_slab_metadata();
+        Config::Backend::dealloc_chunk(
+          get_backend_local_state(), *meta, p, chunk_size);
+        chunks = next;
+      }
+
+#ifdef SNMALLOC_TRACING
+      message<1024>(
+        "reserve_chunks size={} count={} result={}", size, count, result);
+#endif
+      return result;
+    }
+
     /**
      * Flush the cached state and delayed deallocations
      *
@@ -883,17 +1093,20 @@ namespace snmalloc
         // Process incoming message queue
         // Loop as normally only processes a batch
         while (has_messages())
-          handle_message_queue([]() {});
+          handle_message_queue_inner([]() {});
       }
 
       auto posted = attached_cache->flush<sizeof(CoreAllocator), Config>(
         backend_state_ptr(),
-        [&](capptr::Alloc<void> p) { dealloc_local_object(p); });
+        [&](capptr::Alloc<void> p) { dealloc_local_object(p); },
+        events);
 
       // We may now have unused slabs, return to the global allocator.
+      // Reservations do not survive a flush.
       for (smallsizeclass_t sizeclass = 0; sizeclass < NUM_SMALL_SIZECLASSES;
            sizeclass++)
       {
+        alloc_classes[sizeclass].reserved = 0;
         dealloc_local_slabs<true>(sizeclass);
       }
 
@@ -908,6 +1121,39 @@ namespace snmalloc
       return posted;
     }
 
+    /**
+     * Flush the cached state, and then return the memory cached by the
+     * backend local state, so that it can be used by other allocators.
+     *
+     * Returns true if messages are sent to other threads.
+     */
+    bool purge()
+    {
+      purge_epoch = MemoryPressure::get_epoch();
+      auto posted = flush();
+      BackendEventScope backend_events(events);
+      Config::Backend::purge(get_backend_local_state());
+      return posted;
+    }
+
+    /**
+     * Called on the allocation slow paths.  If another thread has run out of
+     * memory since this allocator last checked, return the memory cached by
+     * the backend for this allocator, and send the deallocations batched for
+     * other allocators to their owners, so that they can free their slabs.
+     */
+    SNMALLOC_FAST_PATH void check_memory_pressure()
+    {
+      auto epoch = MemoryPressure::get_epoch();
+      if (SNMALLOC_UNLIKELY(epoch != purge_epoch))
+      {
+        purge_epoch = epoch;
+        post();
+        BackendEventScope backend_events(events);
+        Config::Backend::purge(get_backend_local_state());
+      }
+    }
+
     // This allows the caching layer to be attached to an underlying
     // allocator instance.
     void attach(LocalCache* c)
@@ -915,6 +1161,7 @@ namespace snmalloc
 #ifdef SNMALLOC_TRACING
       message<1024>("Attach cache to {}", this);
 #endif
+      EventLog::record(LogEvent::AttachCache, address_cast(this));
       attached_cache = c;
 
       // Set up secrets.
@@ -923,8 +1170,8 @@ namespace snmalloc
       // Set up remote allocator.
       c->remote_allocator = public_state();
 
-      // Set up remote cache.
-      c->remote_dealloc_cache.init();
+      // The remote cache is set up lazily by the first remote deallocation.
+      c->remote_dealloc_cache.capacity = 0;
     }
 
     /**
@@ -1018,6 +1265,131 @@ namespace snmalloc
 
       return debug_is_empty_impl(result);
     }
+
+    /**
+     * Returns true if other threads have sent deallocations to this allocator
+     * since it last drained its message queue.  This may be called from any
+     * thread, so compares the address of the last message with that seen at
+     * the last drain, rather than reading the queue.  The last message cannot
+     * be freed and sent again until a later one has arrived and been
+     * drained, so an address does not recur unnoticed.
+     */
+    bool has_pending_messages()
+    {
+      return message_queue().back_address() !=
+        handled_back.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Set bit `i` of `bitmap` if the `i`th object of the slab containing `p`
+     * is allocated, and return the number of objects on the slab.  A large
+     * allocation is a slab of one object.  Returns zero, leaving `bitmap`
+     * alone, if `p` is not in a slab or large allocation of this allocator.
+     *
+     * Deallocations sent by other threads are processed first.  Those still
+     * held in the other threads' caches, and the last object sent, which is
+     * kept in the message queue until another arrives, are reported as
+     * allocated.
+     *
+     * This reads the free lists of this allocator, so must not run while
+     * another thread is using it.  It is cheap, and does nothing, for a `p`
+     * that this allocator does not own.
+     */
+    size_t allocated_objects(address_t p, uint64_t* bitmap)
+    {
+      if (!owns(p))
+        return 0;
+
+      if (attached_cache == nullptr)
+      {
+        // Handling messages needs a cache, so set one up temporarily, as
+        // `debug_is_empty` does.
+        LocalCache temp(public_state());
+        attach(&temp);
+        auto count = allocated_objects_impl(p, bitmap);
+        flush();
+        attached_cache = nullptr;
+        return count;
+      }
+
+      return allocated_objects_impl(p, bitmap);
+    }
+
+  private:
+    /**
+     * Returns true if `p` is in a slab or large allocation of this
+     * allocator.
+     */
+    bool owns(address_t p)
+    {
+      const PagemapEntry& entry =
+        Config::Backend::template get_metaentry<true>(p);
+      return !entry.is_backend_owned() &&
+        (entry.get_remote() == public_state());
+    }
+
+    size_t allocated_objects_impl(address_t p, uint64_t* bitmap)
+    {
+      while (has_messages())
+        handle_message_queue_inner([]() {});
+
+      // Handling the messages may have returned the memory to the backend.
+      if (!owns(p))
+        return 0;
+
+      const PagemapEntry& entry =
+        Config::Backend::template get_metaentry<true>(p);
+
+      auto sizeclass = entry.get_sizeclass();
+      if (!sizeclass.is_small())
+      {
+        bitmap[0] = 1;
+        return 1;
+      }
+
+      auto sc = sizeclass.as_small();
+      size_t count = sizeclass_to_slab_object_count(sc);
+      size_t size = sizeclass_to_size(sc);
+      address_t slab = bits::align_down(p, sizeclass_to_slab_size(sc));
+
+      for (size_t i = 0; i < count; i += 64)
+      {
+        size_t n = bits::min<size_t>(count - i, 64);
+        bitmap[i / 64] = n == 64 ? ~uint64_t(0) : (uint64_t(1) << n) - 1;
+      }
+
+      auto clear = [bitmap, slab, size](auto q) {
+        size_t i = (address_cast(q) - slab) / size;
+        bitmap[i / 64] &= ~(uint64_t(1) << (i % 64));
+      };
+      auto domesticate =
+        [this](freelist::QueuePtr q) SNMALLOC_FAST_PATH_LAMBDA {
+          return capptr_domesticate<Config>(backend_state_ptr(), q);
+        };
+      auto& key = entropy.get_free_list_key();
+
+      entry.get_slab_metadata()->free_queue.iterate(key, domesticate, clear);
+
+      // The free list being allocated from may have been taken from this slab.
+      attached_cache->small_fast_free_lists[sc].iterate(
+        key, domesticate, [clear, slab, count, size](auto q) {
+          if ((address_cast(q) - slab) < count * size)
+            clear(q);
+        });
+
+      return count;
+    }
+
+  public:
+    /**
+     * Accessor, returns the counts of slow paths taken by this allocator, and
+     * of the backend events on its behalf.  All are zero unless
+     * `EventCountersEnabled`.
+     */
+    const EventCounters& get_event_counters() const
+    {
+      return events;
+    }
   };
 
   template<typename Config>
@@ -1040,6 +1412,7 @@ namespace snmalloc
       {
         Config::Pal::error("Failed to initialise thread local allocator.");
       }
+      OverheadStats::add_allocator_metadata(request_size);
 
       capptr::Alloc<void> spare_start = pointer_offset(raw, round_sizeof);
       Range<capptr::bounds::Alloc> r{spare_start, spare};
@@ -1058,4 +1431,51 @@ namespace snmalloc
   template<typename Config>
   using AllocPool =
     Pool<CoreAllocator<Config>, ConstructCoreAlloc<Config>, Config::pool>;
+
+  /**
+   * Returns the memory cached by allocators waiting in the pool when there is
+   * `MemoryPressure`.  Their thread caches were flushed when they were
+   * released, so only the backend local state holds memory.
+   */
+  template<typename Config>
+  class AllocPoolPurge
+  {
+    static void purge(PalNotificationObject*)
+    {
+      purge_unused();
+    }
+
+    static inline PalNotificationObject callback{&purge};
+
+    static void register_callback(bool*) noexcept
+    {
+      MemoryPressure::register_purge(&callback);
+    }
+
+  public:
+    static void purge_unused()
+    {
+      // One atomic operation to extract the stack, another to restore it.
+      auto* first = AllocPool<Config>::extract();
+      auto* alloc = first;
+      decltype(alloc) last;
+
+      if (alloc != nullptr)
+      {
+        while (alloc != nullptr)
+        {
+          Config::Backend::purge(alloc->get_backend_local_state());
+          last = alloc;
+          alloc = AllocPool<Config>::extract(alloc);
+        }
+
+        AllocPool<Config>::restore(first, last);
+      }
+    }
+
+    static void ensure_registered()
+    {
+      Singleton<bool, &register_callback>::get();
+    }
+  };
 } // namespace snmalloc
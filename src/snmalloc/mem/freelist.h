@@ -548,6 +548,16 @@ namespace snmalloc
         c->cleanup();
         return c;
       }
+
+      /**
+       * Apply `f` to each remaining element, without moving the iterator.
+       */
+      template<typename Domesticator, typename F>
+      void iterate(const FreeListKey& key, Domesticator domesticate, F f)
+      {
+        for (auto c = curr; c != nullptr; c = c->read_next(key, domesticate))
+          f(c);
+      }
     };
 
     /**
@@ -788,6 +798,28 @@ namespace snmalloc
         return {first, last};
       }
 
+      /**
+       * Apply `f` to each element of the builder, without removing it.
+       */
+      template<typename Domesticator, typename F>
+      void iterate(const FreeListKey& key, Domesticator domesticate, F f)
+      {
+        for (uint32_t i = 0; i < LENGTH; i++)
+        {
+          if (&head[i] == end[i])
+            continue;
+
+          auto curr = read_head(i, key);
+          while (true)
+          {
+            f(curr);
+            if (address_cast(&(curr->next_object)) == address_cast(end[i]))
+              break;
+            curr = curr->read_next(key, domesticate);
+          }
+        }
+      }
+
       template<typename Domesticator>
       SNMALLOC_FAST_PATH void
       validate(const FreeListKey& key, Domesticator domesticate)
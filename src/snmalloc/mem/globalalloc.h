@@ -34,6 +34,150 @@ namespace snmalloc
 #endif
   }
 
+  /**
+   * Construct allocators ahead of time, so that at least `count` are waiting
+   * in the pool.  The first allocation on a new thread then only needs to
+   * take an allocator from the pool, rather than acquiring its metadata from
+   * the backend and seeding its entropy.  Call this from a thread that is not
+   * on the critical path, for instance before starting a set of workers.
+   */
+  template<SNMALLOC_CONCEPT(IsConfig) Config>
+  inline static void reserve_allocators(size_t count)
+  {
+#ifndef SNMALLOC_PASS_THROUGH
+    static_assert(
+      Config::Options.CoreAllocIsPoolAllocated,
+      "Reserving allocators is available only for pool-allocated "
+      "configurations");
+    call_ensure_init<Config>(nullptr, 0);
+    AllocPool<Config>::reserve(count);
+#else
+    UNUSED(count);
+#endif
+  }
+
+  /**
+   * Return the memory cached by allocators that are not currently in use by
+   * any thread to the global ranges.
+   */
+  template<SNMALLOC_CONCEPT(IsConfig) Config>
+  inline static void purge_unused()
+  {
+#ifndef SNMALLOC_PASS_THROUGH
+    static_assert(
+      Config::Options.CoreAllocIsPoolAllocated,
+      "Purging is available only for pool-allocated configurations");
+    AllocPoolPurge<Config>::purge_unused();
+#endif
+  }
+
+  /**
+   * Limit the memory committed by the allocator to `limit` bytes, or remove
+   * the limit if `limit` is zero.
+   *
+   * An allocation that would exceed the limit first causes the memory cached
+   * by allocators in the pool, and by any other `MemoryPressure` callbacks,
+   * to be returned, and the calling thread's own caches to be flushed, before
+   * being retried.  If it still does not fit, `handler` is called once, as
+   * described by `HeapLimit::set_handler`, and the allocation is retried once
+   * more if it returns true, before failing with `ENOMEM`.
+   */
+  template<SNMALLOC_CONCEPT(IsConfig) Config>
+  inline static void
+  set_heap_limit(size_t limit, bool (*handler)(size_t) = nullptr)
+  {
+#ifndef SNMALLOC_PASS_THROUGH
+    static_assert(
+      Config::Options.CoreAllocIsPoolAllocated,
+      "Heap limits are available only for pool-allocated configurations");
+    static_assert(
+      !Config::Options.IsSingleThreaded,
+      "Single-threaded configurations are not counted towards the heap limit");
+    AllocPoolPurge<Config>::ensure_registered();
+    HeapLimit::set_handler(handler);
+    HeapLimit::set_limit(limit);
+#else
+    UNUSED(limit, handler);
+#endif
+  }
+
+  /**
+   * Add the slow-path event counts of every allocator in the pool, whether or
+   * not it is in use by a thread, into `result`.  These include the backend
+   * events on each allocator's behalf, and the backend events outside any
+   * allocator are added too.  The
+   * counts are only maintained if snmalloc is built with
+   * `SNMALLOC_EVENT_COUNTERS`.
+   */
+  template<SNMALLOC_CONCEPT(IsConfig) Config>
+  inline static void get_event_counters(EventCounters& result)
+  {
+#ifndef SNMALLOC_PASS_THROUGH
+    static_assert(
+      Config::Options.CoreAllocIsPoolAllocated,
+      "Global statistics are available only for pool-allocated "
+      "configurations");
+    auto* alloc = AllocPool<Config>::iterate();
+    while (alloc != nullptr)
+    {
+      result.add(alloc->get_event_counters());
+      alloc = AllocPool<Config>::iterate(alloc);
+    }
+    result.add(EventCounters::backend());
+#else
+    UNUSED(result);
+#endif
+  }
+
+  /**
+   * For conservative garbage collectors that scan the whole heap.  As
+   * `LocalAllocator::allocated_objects`, but for a slab owned by any
+   * allocator in the pool, whether or not it is in use by a thread.
+   *
+   * This reads the free lists and handles the messages of the allocator that
+   * owns the slab, so that allocator must be quiesced: either waiting in the
+   * pool, or its thread stopped by the collector outside any call into
+   * snmalloc.  Other allocators are only compared with the slab's owner.
+   */
+  template<SNMALLOC_CONCEPT(IsConfig) Config>
+  inline static size_t allocated_objects(const void* p, uint64_t* bitmap)
+  {
+#ifndef SNMALLOC_PASS_THROUGH
+    static_assert(
+      Config::Options.CoreAllocIsPoolAllocated,
+      "Walking the heap is available only for pool-allocated configurations");
+    auto* alloc = AllocPool<Config>::iterate();
+    while (alloc != nullptr)
+    {
+      auto count = alloc->allocated_objects(address_cast(p), bitmap);
+      if (count != 0)
+        return count;
+      alloc = AllocPool<Config>::iterate(alloc);
+    }
+#else
+    UNUSED(p, bitmap);
+#endif
+    return 0;
+  }
+
+  /**
+   * Print the slow-path event counts, aggregated as by `get_event_counters`.
+   */
+  template<SNMALLOC_CONCEPT(IsConfig) Config>
+  inline static void print_event_counters()
+  {
+    EventCounters counters;
+    get_event_counters<Config>(counters);
+    for (size_t i = 0; i < NUM_EVENTS; i++)
+    {
+      message<1024>(
+        "snmalloc event {}: {}",
+        event_names[i],
+        // Signed, so that the count is printed in decimal.
+        static_cast<long long>(counters.get(static_cast<Event>(i))));
+    }
+  }
+
   /**
     If you pass a pointer to a bool, then it returns whether all the
     allocators are empty. If you don't pass a pointer to a bool, then will
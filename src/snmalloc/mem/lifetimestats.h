@@ -0,0 +1,188 @@
+#pragma once
+
+#include "../ds/ds.h"
+#include "sizeclasstable.h"
+
+#include <atomic>
+
+namespace snmalloc
+{
+  /**
+   * Are object lifetimes sampled?  This adds a countdown to the allocation
+   * fast path, and a filter lookup to the deallocation fast path, so is off
+   * by default.  Define `SNMALLOC_LIFETIME_STATS` to enable it.
+   */
+#if defined(SNMALLOC_LIFETIME_STATS) && !defined(SNMALLOC_PASS_THROUGH)
+  static constexpr bool LifetimeStatsEnabled = true;
+#else
+  static constexpr bool LifetimeStatsEnabled = false;
+#endif
+
+  /**
+   * Process-wide histograms of the lifetimes of sampled objects, for each
+   * sizeclass.  Lifetimes are measured in `Aal::tick()` units, which are
+   * processor cycles on most platforms, and bucketed by their base-2
+   * logarithm: bucket `i` counts lifetimes in [2^i, 2^(i+1)), and bucket 0
+   * also counts those of zero.
+   *
+   * One in `SAMPLE_INTERVAL` allocations by each thread records its address
+   * and time in a side table.  Every deallocation checks a filter of the
+   * addresses in the table, which is a single load unless the object may be
+   * sampled, and if the object is in the table its lifetime is added to the
+   * histogram of its sizeclass.
+   *
+   * The table is fixed size.  A sample that finds no free entry near its
+   * slot is dropped, and objects that are never freed keep their entries.
+   */
+  class LifetimeStats
+  {
+  public:
+    static constexpr size_t SAMPLE_INTERVAL = 10000;
+
+    /// Index of the histogram for large allocations.
+    static constexpr size_t LARGE = NUM_SMALL_SIZECLASSES;
+
+    static constexpr size_t BUCKETS = bits::BITS;
+
+  private:
+    static constexpr size_t TABLE_BITS = 12;
+    static constexpr size_t TABLE_SIZE = bits::one_at_bit(TABLE_BITS);
+
+    /**
+     * Bits of the filter index.  The table index is a prefix of the filter
+     * index, so the entries that share a filter count are all within the
+     * same window of the table, and there are at most `WINDOW` of them.
+     */
+    static constexpr size_t FILTER_BITS = 14;
+    static constexpr size_t FILTER_SIZE = bits::one_at_bit(FILTER_BITS);
+
+    /// Entries of the table that are searched for each address.
+    static constexpr size_t WINDOW = 8;
+    static_assert(WINDOW <= UINT8_MAX, "Filter counts must not overflow");
+
+    /// Addresses of the sampled objects, zero where an entry is free.
+    static inline std::atomic<address_t> addresses[TABLE_SIZE]{};
+    static inline std::atomic<uint64_t> ticks[TABLE_SIZE]{};
+    static inline std::atomic<uint8_t> indices[TABLE_SIZE]{};
+    static_assert(LARGE <= UINT8_MAX, "Sizeclass indices must fit");
+
+    /// The number of entries in the table for each filter index.
+    static inline std::atomic<uint8_t> filter[FILTER_SIZE]{};
+
+    static inline std::atomic<uint64_t> histogram[LARGE + 1][BUCKETS]{};
+    static inline std::atomic<uint64_t> sum[LARGE + 1]{};
+
+    static inline std::atomic<uint64_t> dropped{0};
+
+    static SNMALLOC_FAST_PATH uint64_t hash(address_t p)
+    {
+      return static_cast<uint64_t>(p >> MIN_ALLOC_BITS) * 0x9e3779b97f4a7c15;
+    }
+
+    static SNMALLOC_FAST_PATH size_t filter_index(uint64_t h)
+    {
+      return static_cast<size_t>(h >> (64 - FILTER_BITS));
+    }
+
+    static size_t table_index(uint64_t h)
+    {
+      return static_cast<size_t>(h >> (64 - TABLE_BITS));
+    }
+
+    static SNMALLOC_SLOW_PATH void dealloc_slow(address_t p, uint64_t h)
+    {
+      auto start = table_index(h);
+      for (size_t i = 0; i < WINDOW; i++)
+      {
+        auto slot = (start + i) & (TABLE_SIZE - 1);
+        if (addresses[slot].load(std::memory_order_acquire) != p)
+          continue;
+
+        uint64_t lifetime =
+          Aal::tick() - ticks[slot].load(std::memory_order_relaxed);
+        size_t index = indices[slot].load(std::memory_order_relaxed);
+        filter[filter_index(h)].fetch_sub(1, std::memory_order_relaxed);
+        addresses[slot].store(0, std::memory_order_release);
+
+        size_t bucket = 0;
+        if (lifetime != 0)
+        {
+          auto l = static_cast<size_t>(
+            bits::min(lifetime, static_cast<uint64_t>(SIZE_MAX)));
+          bucket = bits::BITS - 1 - bits::clz(l);
+        }
+        histogram[index][bucket].fetch_add(1, std::memory_order_relaxed);
+        sum[index].fetch_add(lifetime, std::memory_order_relaxed);
+        return;
+      }
+    }
+
+  public:
+    /**
+     * Record a sampled allocation of `size` bytes at `p`.
+     */
+    static SNMALLOC_SLOW_PATH void sample(address_t p, size_t size)
+    {
+      size_t index = LARGE;
+      if (size <= sizeclass_to_size(NUM_SMALL_SIZECLASSES - 1))
+        index = size_to_sizeclass(size);
+
+      auto h = hash(p);
+      auto start = table_index(h);
+      for (size_t i = 0; i < WINDOW; i++)
+      {
+        auto slot = (start + i) & (TABLE_SIZE - 1);
+        address_t expected = 0;
+        if (!addresses[slot].compare_exchange_strong(
+              expected, p, std::memory_order_acquire))
+          continue;
+
+        // The object cannot be freed until it has been returned, so these
+        // need not be published with the address.
+        ticks[slot].store(Aal::tick(), std::memory_order_relaxed);
+        indices[slot].store(
+          static_cast<uint8_t>(index), std::memory_order_relaxed);
+        filter[filter_index(h)].fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+      dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * Check whether the object at `p`, which is being freed, was sampled,
+     * and if so record its lifetime.
+     */
+    static SNMALLOC_FAST_PATH void on_dealloc(address_t p)
+    {
+      auto h = hash(p);
+      if (SNMALLOC_UNLIKELY(
+            filter[filter_index(h)].load(std::memory_order_relaxed) != 0))
+        dealloc_slow(p, h);
+    }
+
+    /**
+     * The number of lifetimes in `bucket` of the histogram for the small
+     * sizeclass `index`, or for `LARGE`.
+     */
+    static uint64_t get_count(size_t index, size_t bucket)
+    {
+      return histogram[index][bucket].load(std::memory_order_relaxed);
+    }
+
+    /**
+     * The total of the lifetimes in the histogram for `index`.
+     */
+    static uint64_t get_sum(size_t index)
+    {
+      return sum[index].load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Samples not taken as the table was full near their slot.
+     */
+    static uint64_t get_dropped()
+    {
+      return dropped.load(std::memory_order_relaxed);
+    }
+  };
+} // namespace snmalloc
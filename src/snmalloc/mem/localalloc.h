@@ -9,12 +9,15 @@
 #endif
 
 #include "../ds/ds.h"
+#include "allochooks.h"
 #include "corealloc.h"
 #include "freelist.h"
+#include "lifetimestats.h"
 #include "localcache.h"
 #include "pool.h"
 #include "remotecache.h"
 #include "sizeclasstable.h"
+#include "threadstats.h"
 
 #ifdef SNMALLOC_PASS_THROUGH
 #  include "external_alloc.h"
@@ -41,6 +44,50 @@ namespace snmalloc
     OnePastEnd
   };
 
+  /**
+   * Counts down the events until the next is sampled, for a sampler that
+   * can be compiled out.  When `Enabled` is false this is empty, so costs no
+   * space or initialisation, and never fires.  `Id` distinguishes the
+   * countdowns of one allocator, as empty members share an address only if
+   * their types differ.
+   */
+  template<bool Enabled, size_t Id>
+  class SampleCountdown
+  {
+    size_t count;
+
+  public:
+    constexpr SampleCountdown(size_t interval) : count(interval) {}
+
+    /**
+     * Count an event.  Returns true if it should be sampled, in which case
+     * the caller restarts the countdown with `reset`.
+     */
+    SNMALLOC_FAST_PATH bool tick()
+    {
+      return --count == 0;
+    }
+
+    void reset(size_t interval)
+    {
+      count = interval;
+    }
+  };
+
+  template<size_t Id>
+  class SampleCountdown<false, Id>
+  {
+  public:
+    constexpr SampleCountdown(size_t) {}
+
+    SNMALLOC_FAST_PATH bool tick()
+    {
+      return false;
+    }
+
+    void reset(size_t) {}
+  };
+
   /**
    * A local allocator contains the fast-path allocation routines and
    * encapsulates all of the behaviour of an allocator that is local to some
@@ -89,6 +136,27 @@ namespace snmalloc
     // the underlying data structures after the call.
     bool post_teardown{false};
 
+    // Bytes allocated and deallocated by this allocator.  Empty unless
+    // `ThreadStatsEnabled`.
+    SNMALLOC_NO_UNIQUE_ADDRESS ThreadStatsField thread_stats;
+
+    // Allocations until the next is sampled for `OverheadStats`.  Empty
+    // unless `OverheadStatsEnabled`.
+    SNMALLOC_NO_UNIQUE_ADDRESS SampleCountdown<OverheadStatsEnabled, 0>
+      overhead_countdown{OverheadStats::SAMPLE_INTERVAL};
+
+    // Allocations until the next is sampled for `LifetimeStats`.  Empty
+    // unless `LifetimeStatsEnabled`.
+    SNMALLOC_NO_UNIQUE_ADDRESS SampleCountdown<LifetimeStatsEnabled, 1>
+      lifetime_countdown{LifetimeStats::SAMPLE_INTERVAL};
+
+    // Small allocations and deallocations until the next is reported to the
+    // `AllocHooks`.  Empty unless `AllocHookSamplingEnabled`.
+    SNMALLOC_NO_UNIQUE_ADDRESS SampleCountdown<AllocHookSamplingEnabled, 2>
+      hook_alloc_countdown{AllocHooks::IDLE_INTERVAL};
+    SNMALLOC_NO_UNIQUE_ADDRESS SampleCountdown<AllocHookSamplingEnabled, 3>
+      hook_dealloc_countdown{AllocHooks::IDLE_INTERVAL};
+
     /**
      * Checks if the core allocator has been initialised, and runs the
      * `action` with the arguments, args.
@@ -162,12 +230,45 @@ namespace snmalloc
           // We didn't have an allocator because the thread is being torndown.
           // We need to return any local state, so we don't leak it.
           flush();
+          EventLog::release();
         }
 
         return r;
       }
     }
 
+    /**
+     * Called when the backend cannot provide memory for an allocation of
+     * `size` bytes, because the `HeapLimit` has been reached or the platform
+     * has refused to reserve or commit more memory.  This is the only place
+     * that such a failure is retried, and it holds no backend lock.
+     *
+     * Returns the memory cached by this thread, including the deallocations
+     * it has batched for other allocators, and by every registered
+     * `MemoryPressure` callback, which covers the allocators in the pool that
+     * no thread is using, and runs `retry` again.  If that also fails, the
+     * `HeapLimit` handler is called once, and if it asks for it, `retry` is
+     * run once more.  `retry` returns true if it succeeded.
+     *
+     * The caches of allocators in use by other threads cannot be reached from
+     * here.  Purging advances the `MemoryPressure` epoch, and each of those
+     * allocators returns its backend cache and batched deallocations on its
+     * next allocation slow path, so they help only later requests.  Slabs
+     * that another thread keeps for reuse, and objects waiting in its message
+     * queue, are not returned until it next handles its messages or flushes.
+     */
+    template<typename Retry>
+    SNMALLOC_SLOW_PATH static bool
+    retry_after_purge(CoreAlloc* core_alloc, size_t size, Retry retry)
+    {
+      MemoryPressure::purge();
+      core_alloc->purge();
+      if (retry())
+        return true;
+
+      return HeapLimit::call_handler(size) && retry();
+    }
+
     /**
      * Allocation that are larger than are handled by the fast allocator must be
      * passed to the core allocator.
@@ -191,25 +292,44 @@ namespace snmalloc
           errno = ENOMEM;
           return capptr::Alloc<void>{nullptr};
         }
+        core_alloc->check_memory_pressure();
+        BackendEventScope backend_events(core_alloc->events);
+
         // Grab slab of correct size
         // Set remote as large allocator remote.
-        auto [chunk, meta] = Config::Backend::alloc_chunk(
-          core_alloc->get_backend_local_state(),
-          large_size_to_chunk_size(size),
-          PagemapEntry::encode(
-            core_alloc->public_state(), size_to_sizeclass_full(size)));
+        auto alloc_chunk = [&]() {
+          return Config::Backend::alloc_chunk(
+            core_alloc->get_backend_local_state(),
+            large_size_to_chunk_size(size),
+            PagemapEntry::encode(
+              core_alloc->public_state(), size_to_sizeclass_full(size)));
+        };
+        auto result = alloc_chunk();
+        if (SNMALLOC_UNLIKELY(result.second == nullptr))
+        {
+          retry_after_purge(core_alloc, size, [&]() {
+            result = alloc_chunk();
+            return result.second != nullptr;
+          });
+        }
+        auto [chunk, meta] = result;
         // set up meta data so sizeclass is correct, and hence alloc size, and
         // external pointer.
 #ifdef SNMALLOC_TRACING
         message<1024>("size {} pow2size {}", size, bits::next_pow2_bits(size));
 #endif
+        EventLog::record(LogEvent::LargeAlloc, address_cast(chunk), size);
 
         // Initialise meta data for a successful large allocation.
         if (meta != nullptr)
         {
           meta->initialise_large(
             address_cast(chunk), local_cache.entropy.get_free_list_key());
+          meta->set_tag(local_cache.tag, large_size_to_chunk_size(size));
+          SizeclassStats::add_large(large_size_to_chunk_size(size));
           core_alloc->laden.insert(meta);
+          if (SNMALLOC_UNLIKELY(AllocHooks::active()))
+            AllocHooks::alloc(chunk.unsafe_ptr(), size);
         }
 
         if (zero_mem == YesZero && chunk.unsafe_ptr() != nullptr)
@@ -239,7 +359,18 @@ namespace snmalloc
               CoreAlloc* core_alloc,
               smallsizeclass_t sizeclass,
               freelist::Iter<>* fl) {
-              return core_alloc->template small_alloc<zero_mem>(sizeclass, *fl);
+              auto r =
+                core_alloc->template small_alloc<zero_mem>(sizeclass, *fl);
+              if (SNMALLOC_UNLIKELY(r == nullptr))
+              {
+                retry_after_purge(
+                  core_alloc, sizeclass_to_size(sizeclass), [&]() {
+                    r = core_alloc->template small_alloc<zero_mem>(
+                      sizeclass, *fl);
+                    return r != nullptr;
+                  });
+              }
+              return r;
             },
             core_alloc,
             sizeclass,
@@ -256,6 +387,94 @@ namespace snmalloc
         domesticate, size, slowpath);
     }
 
+    /**
+     * Record a successful allocation of `size` bytes in the thread
+     * statistics, and sample it for the overhead and lifetime statistics.
+     * This is applied by the entry points rather than in `small_alloc` and
+     * `alloc_not_small`, as those recurse on lazy initialisation.
+     */
+    SNMALLOC_FAST_PATH capptr::Alloc<void>
+    count_alloc(capptr::Alloc<void> p, size_t size)
+    {
+      if constexpr (ThreadStatsEnabled)
+      {
+        if (SNMALLOC_LIKELY(p != nullptr))
+          thread_stats.on_alloc(round_size(size));
+      }
+      if constexpr (OverheadStatsEnabled)
+      {
+        if (SNMALLOC_UNLIKELY(overhead_countdown.tick()))
+        {
+          overhead_countdown.reset(OverheadStats::SAMPLE_INTERVAL);
+          if (p != nullptr)
+            OverheadStats::sample(size);
+        }
+      }
+      if constexpr (LifetimeStatsEnabled)
+      {
+        if (SNMALLOC_UNLIKELY(lifetime_countdown.tick()))
+        {
+          lifetime_countdown.reset(LifetimeStats::SAMPLE_INTERVAL);
+          if (p != nullptr)
+            LifetimeStats::sample(address_cast(p), size);
+        }
+      }
+      if constexpr (AllocHookSamplingEnabled)
+      {
+        if (SNMALLOC_UNLIKELY(hook_alloc_countdown.tick()))
+          sample_alloc_hook(p, size);
+      }
+      UNUSED(size);
+      return p;
+    }
+
+    /**
+     * Report a sampled allocation to the `AllocHooks`.  Large allocations are
+     * reported by `alloc_not_small`, so are not reported again.
+     */
+    SNMALLOC_SLOW_PATH void
+    sample_alloc_hook(capptr::Alloc<void> p, size_t size)
+    {
+      hook_alloc_countdown.reset(AllocHooks::sample_interval());
+      if (
+        AllocHooks::sampling() && (p != nullptr) &&
+        (size <= sizeclass_to_size(NUM_SMALL_SIZECLASSES - 1)))
+        AllocHooks::alloc(p.unsafe_ptr(), size);
+    }
+
+    /**
+     * Record the deallocation of the object at `p`, described by `entry`, in
+     * the thread statistics, and its lifetime if it was sampled.
+     */
+    SNMALLOC_FAST_PATH void
+    count_dealloc(capptr::Alloc<void> p, const PagemapEntry& entry)
+    {
+      if constexpr (ThreadStatsEnabled)
+        thread_stats.on_dealloc(sizeclass_full_to_size(entry.get_sizeclass()));
+      if constexpr (LifetimeStatsEnabled)
+        LifetimeStats::on_dealloc(address_cast(p));
+      if constexpr (AllocHookSamplingEnabled)
+      {
+        if (SNMALLOC_UNLIKELY(hook_dealloc_countdown.tick()))
+          sample_dealloc_hook(p, entry);
+      }
+      UNUSED(p, entry);
+    }
+
+    /**
+     * Report a sampled deallocation to the `AllocHooks`.  Large
+     * deallocations are reported by the core allocator, so are not reported
+     * again.
+     */
+    SNMALLOC_SLOW_PATH void
+    sample_dealloc_hook(capptr::Alloc<void> p, const PagemapEntry& entry)
+    {
+      hook_dealloc_countdown.reset(AllocHooks::sample_interval());
+      auto sizeclass = entry.get_sizeclass();
+      if (AllocHooks::sampling() && sizeclass.is_small())
+        AllocHooks::dealloc(p.unsafe_ptr(), sizeclass_full_to_size(sizeclass));
+    }
+
     /**
      * Send all remote deallocation to other threads.
      */
@@ -283,8 +502,11 @@ namespace snmalloc
           p.unsafe_ptr(),
           alloc_size(p.unsafe_ptr()));
 #endif
+        EventLog::record(LogEvent::RemoteDealloc, address_cast(p));
         const PagemapEntry& entry =
           Config::Backend::template get_metaentry(address_cast(p));
+        count_dealloc(p, entry);
+        local_cache.remote_dealloc_cache.ensure_init();
         local_cache.remote_dealloc_cache.template dealloc<sizeof(CoreAlloc)>(
           entry.get_remote()->trunc_id(), p);
         post_remote_cache();
@@ -297,7 +519,8 @@ namespace snmalloc
       // between being ours to handle and something to post to a Remote.)
       lazy_init(
         [&](CoreAlloc*, CapPtr<void, capptr::bounds::Alloc> p) {
-          dealloc(p.unsafe_ptr()); // TODO don't double count statistics
+          // The statistics are updated by this call, not by our caller.
+          dealloc(p.unsafe_ptr());
           return nullptr;
         },
         p);
@@ -322,25 +545,6 @@ namespace snmalloc
       return call_is_initialised<Config>(nullptr, 0);
     }
 
-    /**
-     * SFINAE helper.  Matched only if `T` implements `ensure_init`.  Calls it
-     * if it exists.
-     */
-    template<typename T>
-    SNMALLOC_FAST_PATH auto call_ensure_init(T*, int)
-      -> decltype(T::ensure_init())
-    {
-      T::ensure_init();
-    }
-
-    /**
-     * SFINAE helper.  Matched only if `T` does not implement `ensure_init`.
-     * Does nothing if called.
-     */
-    template<typename T>
-    SNMALLOC_FAST_PATH auto call_ensure_init(T*, long)
-    {}
-
     /**
      * Call `Config::ensure_init()` if it is implemented, do
      * nothing otherwise.
@@ -382,6 +586,8 @@ namespace snmalloc
 #ifdef SNMALLOC_TRACING
       message<1024>("init(): core_alloc={} @ {}", core_alloc, &local_cache);
 #endif
+      EventLog::record(
+        LogEvent::Init, address_cast(core_alloc), address_cast(&local_cache));
       // local_cache.stats.sta rt();
     }
 
@@ -392,6 +598,9 @@ namespace snmalloc
     {
       // Initialise the global allocator structures
       ensure_init();
+      // Allow memory cached by pooled allocators to be reclaimed when memory
+      // is short.
+      AllocPoolPurge<Config>::ensure_registered();
       // Grab an allocator for this thread.
       init(AllocPool<Config>::acquire());
     }
@@ -404,6 +613,7 @@ namespace snmalloc
       // Detached thread local state from allocator.
       if (core_alloc != nullptr)
       {
+        EventLog::record(LogEvent::Flush, address_cast(core_alloc));
         core_alloc->flush();
 
         // core_alloc->stats().add(local_cache.stats);
@@ -429,6 +639,79 @@ namespace snmalloc
       }
     }
 
+    /**
+     * Reserve slabs so that the next `count` allocations from `sizeclass` are
+     * satisfied without fetching new slabs from the backend.  The memory is
+     * faulted in and, if `pin` is set and the platform supports it, pinned.
+     * The reserved slabs are kept until this allocator is flushed.
+     *
+     * Returns false if the memory could not be reserved or pinned.
+     */
+    bool reserve_sizeclass(
+      smallsizeclass_t sizeclass, size_t count, bool pin = false)
+    {
+#ifdef SNMALLOC_PASS_THROUGH
+      UNUSED(sizeclass, count, pin);
+      return true;
+#else
+      bool result = check_init(
+        [](CoreAlloc* core_alloc, auto sizeclass, auto count, auto pin) {
+          return core_alloc->reserve_slabs(sizeclass, count, pin);
+        },
+        sizeclass,
+        count,
+        pin);
+
+      // Move a free list onto the fast path, so the first allocation does not
+      // need to take a slab from the core allocator.  The object is not the
+      // application's, so it is returned directly to its slab rather than
+      // through `dealloc`, and is not seen by the statistics or hooks.
+      if (result && local_cache.small_fast_free_lists[sizeclass].empty())
+      {
+        auto p = small_alloc<NoZero>(sizeclass_to_size(sizeclass));
+        if (p != nullptr)
+        {
+          const PagemapEntry& entry =
+            Config::Backend::get_metaentry(address_cast(p));
+          if (!CoreAlloc::dealloc_local_object_fast(
+                entry, p, local_cache.entropy))
+            core_alloc->dealloc_local_object_slow(p, entry);
+        }
+      }
+
+      return result;
+#endif
+    }
+
+    /**
+     * Prepare this allocator to serve `count` allocations of `size` bytes
+     * without going to the backend.  For small sizes this reserves slabs, see
+     * `reserve_sizeclass`.  For larger sizes, this takes `count` faulted in
+     * chunks from the backend and returns them, so that they are held in its
+     * thread-local caches, as far as their capacity allows.  Nothing is
+     * allocated by the frontend, so the statistics and hooks see nothing.
+     *
+     * Returns false if the memory could not be reserved or pinned.
+     */
+    bool prewarm(size_t size, size_t count, bool pin = false)
+    {
+#ifdef SNMALLOC_PASS_THROUGH
+      UNUSED(size, count, pin);
+      return true;
+#else
+      if ((size - 1) <= (sizeclass_to_size(NUM_SMALL_SIZECLASSES - 1) - 1))
+        return reserve_sizeclass(size_to_sizeclass(size), count, pin);
+
+      return check_init(
+        [](CoreAlloc* core_alloc, auto size, auto count, auto pin) {
+          return core_alloc->reserve_chunks(size, count, pin);
+        },
+        size,
+        count,
+        pin);
+#endif
+    }
+
     /**
      * Allocate memory of a dynamically known size.
      */
@@ -452,10 +735,10 @@ namespace snmalloc
       {
         // Small allocations are more likely. Improve
         // branch prediction by placing this case first.
-        return capptr_reveal(small_alloc<zero_mem>(size));
+        return capptr_reveal(count_alloc(small_alloc<zero_mem>(size), size));
       }
 
-      return capptr_reveal(alloc_not_small<zero_mem>(size));
+      return capptr_reveal(count_alloc(alloc_not_small<zero_mem>(size), size));
 #endif
     }
 
@@ -654,6 +937,7 @@ namespace snmalloc
       if (SNMALLOC_LIKELY(local_cache.remote_allocator == entry.get_remote()))
       {
         dealloc_cheri_checks(p_tame.unsafe_ptr());
+        count_dealloc(p_tame, entry);
 
         if (SNMALLOC_LIKELY(CoreAlloc::dealloc_local_object_fast(
               entry, p_tame, local_cache.entropy)))
@@ -676,12 +960,14 @@ namespace snmalloc
         // Check if we have space for the remote deallocation
         if (local_cache.remote_dealloc_cache.reserve_space(entry))
         {
+          count_dealloc(p_tame, entry);
           local_cache.remote_dealloc_cache.template dealloc<sizeof(CoreAlloc)>(
             remote->trunc_id(), p_tame);
 #  ifdef SNMALLOC_TRACING
           message<1024>(
             "Remote dealloc fast {} ({})", p_raw, alloc_size(p_raw));
 #  endif
+          EventLog::record(LogEvent::RemoteDealloc, address_cast(p_raw));
           return;
         }
 
@@ -742,16 +1028,34 @@ namespace snmalloc
       dealloc(p);
     }
 
+    /**
+     * Send the deallocations of other allocators' objects that this
+     * allocator has batched to their owners now, rather than when the batch
+     * is full.
+     */
+    void post_remote()
+    {
+#ifndef SNMALLOC_PASS_THROUGH
+      if (core_alloc != nullptr)
+        post_remote_cache();
+#endif
+    }
+
     void teardown()
     {
 #ifdef SNMALLOC_TRACING
       message<1024>("Teardown: core_alloc={} @ {}", core_alloc, &local_cache);
 #endif
+      EventLog::record(
+        LogEvent::Teardown,
+        address_cast(core_alloc),
+        address_cast(&local_cache));
       post_teardown = true;
       if (core_alloc != nullptr)
       {
         flush();
       }
+      EventLog::release();
     }
 
     SNMALLOC_FAST_PATH size_t alloc_size(const void* p_raw)
@@ -864,6 +1168,84 @@ namespace snmalloc
 #endif
     }
 
+    /**
+     * The number of words needed for the bitmap of `allocated_objects`.
+     */
+    static constexpr size_t ALLOCATED_BITMAP_WORDS =
+      (MAX_SLAB_OBJECT_COUNT + 63) / 64;
+
+    /**
+     * For conservative garbage collectors.  Sets bit `i` of `bitmap`, which
+     * has `ALLOCATED_BITMAP_WORDS` words, if the `i`th object of the slab
+     * containing `p` is allocated.  Returns the number of objects on the
+     * slab, where a large allocation is a slab of one object, or zero if `p`
+     * is not in a slab of this allocator.
+     *
+     * Only the slabs of this allocator are covered.  A collector that scans
+     * the whole heap should stop the other threads and use the global
+     * `snmalloc::allocated_objects`, which finds the owner of any slab.
+     *
+     * Objects freed by other threads are reported as allocated until those
+     * threads have flushed their remote deallocation caches, and the last
+     * one sent to this allocator until another is sent.
+     */
+    size_t allocated_objects(const void* p, uint64_t* bitmap)
+    {
+#ifndef SNMALLOC_PASS_THROUGH
+      if (core_alloc == nullptr)
+        return 0;
+      return core_alloc->allocated_objects(address_cast(p), bitmap);
+#else
+      UNUSED(p, bitmap);
+      return 0;
+#endif
+    }
+
+    /**
+     * For conservative garbage collectors.  Replaces each of the `n` pointers
+     * in `ptrs` with the start of the object it points into, or with null if
+     * it does not point into memory handed out by snmalloc, whichever
+     * allocator owns it.  Whether the object is allocated is given by
+     * `allocated_objects`.
+     *
+     * The pagemap entries are fetched in batches, so that the lookups for a
+     * batch overlap rather than waiting on each cache miss in turn.
+     */
+    void classify(void** ptrs, size_t n)
+    {
+#ifndef SNMALLOC_PASS_THROUGH
+      static constexpr size_t BATCH = 16;
+      for (size_t base = 0; base < n; base += BATCH)
+      {
+        size_t count = bits::min(BATCH, n - base);
+        for (size_t i = 0; i < count; i++)
+        {
+          const PagemapEntry& entry =
+            Config::Backend::template get_metaentry<true>(
+              address_cast(ptrs[base + i]));
+          Aal::prefetch(const_cast<PagemapEntry*>(&entry));
+        }
+
+        for (size_t i = 0; i < count; i++)
+        {
+          void*& p = ptrs[base + i];
+          const PagemapEntry& entry =
+            Config::Backend::template get_metaentry<true>(address_cast(p));
+          if (entry.is_backend_owned() || (entry.get_remote() == nullptr))
+          {
+            p = nullptr;
+            continue;
+          }
+          auto start = start_of_object(entry.get_sizeclass(), address_cast(p));
+          p = pointer_offset(p, 0 - (address_cast(p) - start));
+        }
+      }
+#else
+      for (size_t i = 0; i < n; i++)
+        ptrs[i] = nullptr;
+#endif
+    }
+
     /**
      * Accessor, returns the local cache.  If embedding code is allocating the
      * core allocator for use by this local allocator then it needs to access
@@ -873,5 +1255,33 @@ namespace snmalloc
     {
       return local_cache;
     }
+
+    /**
+     * Accessor, returns the bytes allocated and deallocated by this
+     * allocator.  Both are zero unless `ThreadStatsEnabled`.  The reference
+     * remains valid for the lifetime of the allocator, so can be retained
+     * to read the statistics without a call.
+     */
+    const ThreadStats& get_thread_stats() const
+    {
+      return thread_stats;
+    }
+
+    /**
+     * Set the tag that slabs and large allocations subsequently acquired by
+     * this allocator are attributed to, see `AllocTags`.  Returns the
+     * previous tag.
+     */
+    alloc_tag_t set_tag(alloc_tag_t tag)
+    {
+      auto prev = local_cache.tag;
+      local_cache.tag = tag;
+      return prev;
+    }
+
+    alloc_tag_t get_tag() const
+    {
+      return local_cache.tag;
+    }
   };
 } // namespace snmalloc
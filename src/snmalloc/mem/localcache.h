@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../ds/ds.h"
+#include "alloctag.h"
 #include "freelist.h"
 #include "remotecache.h"
 #include "sizeclasstable.h"
@@ -56,6 +57,12 @@ namespace snmalloc
      */
     RemoteDeallocCache remote_dealloc_cache;
 
+    /**
+     * Tag that slabs and large allocations acquired by this thread are
+     * attributed to.
+     */
+    alloc_tag_t tag{0};
+
     constexpr LocalCache(RemoteAllocator* remote_allocator)
     : remote_allocator(remote_allocator)
     {}
@@ -64,7 +71,10 @@ namespace snmalloc
      * Return all the free lists to the allocator.  Used during thread teardown.
      */
     template<size_t allocator_size, typename Config, typename DeallocFun>
-    bool flush(typename Config::LocalState* local_state, DeallocFun dealloc)
+    bool flush(
+      typename Config::LocalState* local_state,
+      DeallocFun dealloc,
+      EventCountersField& events)
     {
       auto& key = entropy.get_free_list_key();
       auto domesticate = [local_state](freelist::QueuePtr p)
@@ -86,7 +96,7 @@ namespace snmalloc
       }
 
       return remote_dealloc_cache.post<allocator_size, Config>(
-        local_state, remote_allocator->trunc_id());
+        local_state, remote_allocator->trunc_id(), events);
     }
 
     template<
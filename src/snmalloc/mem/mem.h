@@ -1,3 +1,5 @@
+#include "allochooks.h"
+#include "alloctag.h"
 #include "backend_concept.h"
 #include "backend_wrappers.h"
 #include "corealloc.h"
@@ -5,12 +7,16 @@
 #include "external_alloc.h"
 #include "freelist.h"
 #include "globalalloc.h"
+#include "lifetimestats.h"
 #include "localalloc.h"
 #include "localcache.h"
 #include "metadata.h"
+#include "overheadstats.h"
 #include "pool.h"
 #include "pooled.h"
 #include "remoteallocator.h"
 #include "remotecache.h"
+#include "sizeclassstats.h"
 #include "sizeclasstable.h"
+#include "threadstats.h"
 #include "ticker.h"
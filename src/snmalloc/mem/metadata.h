@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../ds/ds.h"
+#include "alloctag.h"
 #include "freelist.h"
 #include "sizeclasstable.h"
 
@@ -424,6 +425,12 @@ namespace snmalloc
      */
     bool large_ = false;
 
+    /**
+     * Tag that the memory of this slab, or large allocation, is attributed
+     * to.  See `AllocTags`.
+     */
+    alloc_tag_t tag_ = 0;
+
     uint16_t& needed()
     {
       return needed_;
@@ -498,6 +505,22 @@ namespace snmalloc
       return large_;
     }
 
+    /**
+     * Attribute `size` bytes of this slab, or large allocation, to `tag`.
+     * This must be matched by a call to `untag` with the same size when the
+     * memory is returned to the backend.
+     */
+    void set_tag(alloc_tag_t tag, size_t size)
+    {
+      tag_ = tag;
+      AllocTags::add(tag, size);
+    }
+
+    void untag(size_t size)
+    {
+      AllocTags::remove(tag_, size);
+    }
+
     /**
      * Try to set this slab metadata to sleep.  If the remaining elements are
      * fewer than the threshold, then it will actually be set to the sleeping
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "../ds/ds.h"
+#include "sizeclasstable.h"
+
+#include <atomic>
+
+namespace snmalloc
+{
+  /**
+   * Is the rounding of requested sizes to sizeclasses sampled?  This adds a
+   * countdown to the allocation fast path, so is off by default.  Define
+   * `SNMALLOC_OVERHEAD_STATS` to enable it.
+   */
+#if defined(SNMALLOC_OVERHEAD_STATS) && !defined(SNMALLOC_PASS_THROUGH)
+  static constexpr bool OverheadStatsEnabled = true;
+#else
+  static constexpr bool OverheadStatsEnabled = false;
+#endif
+
+  /**
+   * Process-wide accounting of the memory that does not hold application
+   * data: the difference between the sizes requested and the sizeclasses
+   * that they were rounded up to, and the allocator's own metadata.
+   *
+   * Metadata is accounted on the slow paths that allocate it, so is always
+   * maintained.  Rounding is sampled: one in `SAMPLE_INTERVAL` allocations
+   * by each thread adds its requested and rounded sizes to the totals for
+   * its sizeclass.
+   */
+  class OverheadStats
+  {
+  public:
+    static constexpr size_t SAMPLE_INTERVAL = 64;
+
+    /// Index of the rounding totals for large allocations.
+    static constexpr size_t LARGE = NUM_SMALL_SIZECLASSES;
+
+  private:
+    static inline std::atomic<uint64_t> requested[NUM_SMALL_SIZECLASSES + 1]{};
+    static inline std::atomic<uint64_t> rounded[NUM_SMALL_SIZECLASSES + 1]{};
+
+    static inline std::atomic<size_t> slab_metadata{0};
+    static inline std::atomic<size_t> allocator_metadata{0};
+    static inline std::atomic<size_t> pagemap{0};
+
+  public:
+    /**
+     * Record a sampled allocation of `size` bytes.
+     */
+    static SNMALLOC_SLOW_PATH void sample(size_t size)
+    {
+      size_t index = LARGE;
+      if (size <= sizeclass_to_size(NUM_SMALL_SIZECLASSES - 1))
+        index = size_to_sizeclass(size);
+      requested[index].fetch_add(size, std::memory_order_relaxed);
+      rounded[index].fetch_add(round_size(size), std::memory_order_relaxed);
+    }
+
+    static void add_slab_metadata(size_t size)
+    {
+      slab_metadata.fetch_add(size, std::memory_order_relaxed);
+    }
+
+    static void remove_slab_metadata(size_t size)
+    {
+      slab_metadata.fetch_sub(size, std::memory_order_relaxed);
+    }
+
+    static void add_allocator_metadata(size_t size)
+    {
+      allocator_metadata.fetch_add(size, std::memory_order_relaxed);
+    }
+
+    static void add_pagemap(size_t size)
+    {
+      pagemap.fetch_add(size, std::memory_order_relaxed);
+    }
+
+    /**
+     * Sampled totals of the sizes requested, and of the sizes that they were
+     * rounded to, for the small sizeclass `index` or for `LARGE`.
+     */
+    static uint64_t get_requested(size_t index)
+    {
+      return requested[index].load(std::memory_order_relaxed);
+    }
+
+    static uint64_t get_rounded(size_t index)
+    {
+      return rounded[index].load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Bytes of `FrontendSlabMetadata` for the slabs and large allocations
+     * currently held.
+     */
+    static size_t get_slab_metadata()
+    {
+      return slab_metadata.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Bytes of core allocator objects.  These are pooled, so never freed.
+     */
+    static size_t get_allocator_metadata()
+    {
+      return allocator_metadata.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Bytes of the pagemap committed for the address space registered with
+     * it.  This is whole pages of entries.
+     */
+    static size_t get_pagemap()
+    {
+      return pagemap.load(std::memory_order_relaxed);
+    }
+  };
+} // namespace snmalloc
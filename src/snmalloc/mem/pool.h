@@ -32,7 +32,7 @@ namespace snmalloc
     capptr::Alloc<T> front{nullptr};
     capptr::Alloc<T> back{nullptr};
 
-    FlagWord lock{};
+    FlagWord lock{"alloc_pool"};
     capptr::Alloc<T> list{nullptr};
 
   public:
@@ -126,6 +126,37 @@ namespace snmalloc
       return p.unsafe_ptr();
     }
 
+    /**
+     * Ensure at least `count` objects are available in the pool, constructing
+     * new ones as required.  Subsequent calls to `acquire` can then be
+     * satisfied without running the constructor, so this can be used to move
+     * the cost of construction off the critical path.
+     */
+    static void reserve(size_t count)
+    {
+      PoolState<T>& pool = get_state();
+      size_t available = 0;
+      {
+        FlagLock f(pool.lock);
+        for (auto p = pool.front; (p != nullptr) && (available < count);
+             p = p->next)
+          available++;
+      }
+
+      for (; available < count; available++)
+      {
+        auto p = ConstructT::make();
+
+        {
+          FlagLock f(pool.lock);
+          p->list_next = pool.list;
+          pool.list = p;
+        }
+
+        restore(p.unsafe_ptr(), p.unsafe_ptr());
+      }
+    }
+
     /**
      * Return to the pool an object previously retrieved by `acquire`
      *
@@ -87,6 +87,27 @@ namespace snmalloc
       return fnt;
     }
 
+    /**
+     * The address of the last message enqueued, or zero if there has been
+     * none.  Unlike the queue's entries, which the owner may free at any
+     * time, this may be read by any thread.  The last message is held in the
+     * queue until another arrives, so its address only changes when a new
+     * message is sent.
+     */
+    address_t back_address()
+    {
+      return address_cast(back.load(std::memory_order_relaxed));
+    }
+
+    /**
+     * The address of the first message that has not been dequeued.  Only
+     * the owner may call this.
+     */
+    address_t front_address()
+    {
+      return address_cast(front.load(std::memory_order_relaxed));
+    }
+
     template<typename Domesticator_head, typename Domesticator_queue>
     inline bool can_dequeue(
       Domesticator_head domesticate_head, Domesticator_queue domesticate_queue)
@@ -122,10 +143,11 @@ namespace snmalloc
       {
         freelist::Object::atomic_store_next(
           domesticate_head(prev), first, key_global);
-        return;
       }
-
-      front.store(capptr_rewild(first));
+      else
+      {
+        front.store(capptr_rewild(first));
+      }
     }
 
     /**
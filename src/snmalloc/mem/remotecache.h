@@ -25,6 +25,10 @@ namespace snmalloc
      * yet. This is initialised to the 0 so that we always hit a slow path to
      * start with, when we hit the slow path and need to dispatch everything, we
      * can check if we are a real allocator and lazily provide a real allocator.
+     *
+     * Zero also means that `list` has not been initialised.  The lists are
+     * only set up by the first remote deallocation, so that attaching a cache
+     * to an allocator does not need to touch every slot.
      */
     int64_t capacity{0};
 
@@ -76,13 +80,24 @@ namespace snmalloc
         r, RemoteAllocator::key_global);
     }
 
+    /**
+     * Send the cached deallocations to their allocators.  Each round of
+     * sending is counted in `events`.
+     */
     template<size_t allocator_size, typename Config>
     bool post(
-      typename Config::LocalState* local_state, RemoteAllocator::alloc_id_t id)
+      typename Config::LocalState* local_state,
+      RemoteAllocator::alloc_id_t id,
+      EventCountersField& events)
     {
       // Use same key as the remote allocator, so segments can be
       // posted to a remote allocator without reencoding.
       const auto& key = RemoteAllocator::key_global;
+
+      // Nothing can have been cached before the lists were initialised.
+      if (capacity == 0)
+        return false;
+
       SNMALLOC_ASSERT(initialised);
       size_t post_round = 0;
       bool sent_something = false;
@@ -93,6 +108,8 @@ namespace snmalloc
 
       while (true)
       {
+        events.count(Event::RemotePostRound);
+        SNMALLOC_TRACEPOINT2(remote_post, id, post_round);
         auto my_slot = get_slot<allocator_size>(id, post_round);
 
         for (size_t i = 0; i < REMOTE_SLOTS; i++)
@@ -179,5 +196,16 @@ namespace snmalloc
       }
       capacity = REMOTE_CACHE;
     }
+
+    /**
+     * Initialise the lists if this is the first remote deallocation since
+     * the cache was attached.  Must be called before `dealloc` on any path
+     * that has not successfully called `reserve_space`.
+     */
+    SNMALLOC_FAST_PATH void ensure_init()
+    {
+      if (SNMALLOC_UNLIKELY(capacity == 0))
+        init();
+    }
   };
 } // namespace snmalloc
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "../ds/ds.h"
+#include "sizeclasstable.h"
+
+#include <atomic>
+
+namespace snmalloc
+{
+  /**
+   * Process-wide counts of the slabs held by allocators for each small
+   * sizeclass, and of the bytes held in large allocations.  These are updated
+   * when an allocator acquires or returns a slab or large chunk, so are not
+   * touched by the fast paths.
+   */
+  class SizeclassStats
+  {
+    static inline std::atomic<size_t> slabs[NUM_SMALL_SIZECLASSES]{};
+
+    static inline std::atomic<size_t> large_bytes{0};
+
+  public:
+    static void add_slab(smallsizeclass_t sizeclass)
+    {
+      slabs[sizeclass].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static void remove_slab(smallsizeclass_t sizeclass)
+    {
+      slabs[sizeclass].fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    static void add_large(size_t size)
+    {
+      large_bytes.fetch_add(size, std::memory_order_relaxed);
+    }
+
+    static void remove_large(size_t size)
+    {
+      large_bytes.fetch_sub(size, std::memory_order_relaxed);
+    }
+
+    /**
+     * Number of slabs of `sizeclass` held by allocators, whether or not they
+     * contain live objects.
+     */
+    static size_t get_slabs(smallsizeclass_t sizeclass)
+    {
+      return slabs[sizeclass].load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Bytes of chunks backing live large allocations.
+     */
+    static size_t get_large_bytes()
+    {
+      return large_bytes.load(std::memory_order_relaxed);
+    }
+  };
+} // namespace snmalloc
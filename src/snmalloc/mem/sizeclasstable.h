@@ -172,6 +172,9 @@ namespace snmalloc
 
     size_t DIV_MULT_SHIFT{0};
 
+    // The largest number of objects on a slab of any sizeclass.
+    size_t max_capacity{0};
+
     [[nodiscard]] constexpr sizeclass_data_fast& fast(sizeclass_t index)
     {
       return fast_[index.raw()];
@@ -205,8 +208,6 @@ namespace snmalloc
 
     constexpr SizeClassTable()
     {
-      size_t max_capacity = 0;
-
       for (sizeclass_compress_t sizeclass = 0;
            sizeclass < NUM_SMALL_SIZECLASSES;
            sizeclass++)
@@ -269,6 +270,8 @@ namespace snmalloc
 
   constexpr SizeClassTable sizeclass_metadata = SizeClassTable();
 
+  constexpr size_t MAX_SLAB_OBJECT_COUNT = sizeclass_metadata.max_capacity;
+
   constexpr size_t DIV_MULT_SHIFT = sizeclass_metadata.DIV_MULT_SHIFT;
 
   constexpr size_t sizeclass_to_size(smallsizeclass_t sizeclass)
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "../ds/ds.h"
+
+#include <cstdint>
+#include <type_traits>
+
+namespace snmalloc
+{
+  /**
+   * Are per-thread allocation statistics maintained?  These are off by
+   * default as they add work to the allocation and deallocation fast paths.
+   * Define `SNMALLOC_THREAD_STATS` to enable them.
+   */
+#if defined(SNMALLOC_THREAD_STATS) && !defined(SNMALLOC_PASS_THROUGH)
+  static constexpr bool ThreadStatsEnabled = true;
+#else
+  static constexpr bool ThreadStatsEnabled = false;
+#endif
+
+  /**
+   * Running totals of the bytes allocated and deallocated through a single
+   * `LocalAllocator`, and hence by a single thread.  Sizes are the usable
+   * size of each object, rather than the size that was requested.
+   *
+   * The totals only increase, so a caller can attribute memory to a piece of
+   * work by reading them before and after.  Deallocations count against the
+   * thread that frees the object, not the one that allocated it.
+   */
+  struct ThreadStats
+  {
+    uint64_t allocated{0};
+    uint64_t deallocated{0};
+
+    SNMALLOC_FAST_PATH void on_alloc(size_t size)
+    {
+      if constexpr (ThreadStatsEnabled)
+        allocated += size;
+      else
+        UNUSED(size);
+    }
+
+    SNMALLOC_FAST_PATH void on_dealloc(size_t size)
+    {
+      if constexpr (ThreadStatsEnabled)
+        deallocated += size;
+      else
+        UNUSED(size);
+    }
+  };
+
+  /**
+   * Stands in for `ThreadStats` in an allocator when thread statistics are
+   * disabled, so that the allocator holds no counters.  It reads as a
+   * `ThreadStats` with both totals zero.
+   */
+  class NoThreadStats
+  {
+    static constexpr ThreadStats zero{};
+
+  public:
+    SNMALLOC_FAST_PATH void on_alloc(size_t) {}
+
+    SNMALLOC_FAST_PATH void on_dealloc(size_t) {}
+
+    operator const ThreadStats&() const
+    {
+      return zero;
+    }
+  };
+
+  using ThreadStatsField =
+    std::conditional_t<ThreadStatsEnabled, ThreadStats, NoThreadStats>;
+} // namespace snmalloc
@@ -1,6 +1,6 @@
 #pragma once
 
-#include "../ds_core/ds_core.h"
+#include "../ds/ds.h"
 
 #include <cstdint>
 
@@ -45,6 +45,12 @@ namespace snmalloc
     {
       uint64_t now_ms = PAL::time_in_ms();
 
+      // Piggyback the periodic check of the memory budget, and the
+      // publication of statistics, on the clock.  Both do nothing unless the
+      // program has enabled them.
+      MemoryBudget::tick<PAL>(now_ms);
+      StatsPublisher::tick(now_ms);
+
       // Set up clock.
       if (last_query_ms == 0)
       {
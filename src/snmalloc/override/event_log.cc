@@ -0,0 +1,32 @@
+#include "export.h"
+#include "override.h"
+
+#if defined(SNMALLOC_EVENT_LOG) && (defined(__unix__) || defined(__APPLE__))
+#  include <stdlib.h>
+
+using namespace snmalloc;
+
+/**
+ * Writing of the binary event log from a preloaded shim built with
+ * `SNMALLOC_EVENT_LOG`.  If `SNMALLOC_EVENT_LOG_FILE` is set when the library
+ * is loaded, the log is written to that file at exit, for decoding with the
+ * `eventlog` tool.
+ */
+namespace
+{
+  char event_log_path[256];
+
+  void write_event_log()
+  {
+    shim::write_file(
+      event_log_path, [](auto& sink) { EventLog::write(sink); });
+  }
+
+  __attribute__((constructor)) void event_log_constructor()
+  {
+    if (!shim::getenv_path("SNMALLOC_EVENT_LOG_FILE", event_log_path))
+      return;
+    atexit(&write_event_log);
+  }
+} // namespace
+#endif
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "../global/global.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#  include <errno.h>
+#  include <fcntl.h>
+#  include <stdlib.h>
+#  include <string.h>
+#  include <unistd.h>
+
+/**
+ * Helpers shared by the parts of the shim that are configured from the
+ * environment and write reports to files.  None of these allocate.
+ */
+namespace snmalloc::shim
+{
+  /**
+   * Parse `s` as an unsigned decimal number.  Returns false if it is empty or
+   * contains anything other than digits.
+   */
+  inline bool parse_decimal(const char* s, uint64_t& result)
+  {
+    if (*s == '\0')
+      return false;
+
+    result = 0;
+    for (; *s != '\0'; s++)
+    {
+      if (*s < '0' || *s > '9')
+        return false;
+      result = result * 10 + static_cast<uint64_t>(*s - '0');
+    }
+    return true;
+  }
+
+  /**
+   * Read the environment variable `name` as an unsigned decimal number.
+   * Returns false if it is not set, or, with a message, if it is not a
+   * number.
+   */
+  inline bool getenv_decimal(const char* name, uint64_t& result)
+  {
+    const char* value = getenv(name);
+    if ((value == nullptr) || (*value == '\0'))
+      return false;
+
+    if (!parse_decimal(value, result))
+    {
+      message<1024>("snmalloc: {} is not a number", name);
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * Copy the path in the environment variable `name` into `path`, so that
+   * it can be used after the environment has changed.  Returns false if it
+   * is not set, or, with a message, if it does not fit.
+   */
+  template<size_t N>
+  inline bool getenv_path(const char* name, char (&path)[N])
+  {
+    const char* value = getenv(name);
+    if ((value == nullptr) || (*value == '\0'))
+      return false;
+
+    if (strlen(value) >= N)
+    {
+      message<1024>("snmalloc: {} is too long", name);
+      return false;
+    }
+    strcpy(path, value);
+    return true;
+  }
+
+  /**
+   * Replace the contents of the file at `path` with the output of
+   * `generate`, which is called as `generate(sink)`, and in turn calls
+   * `sink(const void* data, size_t length)` for each piece of the output.
+   *
+   * This uses only async-signal-safe calls and preserves `errno`, so may be
+   * called from a signal handler or at exit.  Errors are ignored.
+   */
+  template<typename Generate>
+  inline void write_file(const char* path, Generate generate)
+  {
+    int saved_errno = errno;
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+      errno = saved_errno;
+      return;
+    }
+
+    auto sink = [fd](const void* data, size_t length) {
+      auto* p = static_cast<const char*>(data);
+      while (length != 0)
+      {
+        auto written = write(fd, p, length);
+        if (written <= 0)
+          return;
+        p += written;
+        length -= static_cast<size_t>(written);
+      }
+    };
+    generate(sink);
+    close(fd);
+    errno = saved_errno;
+  }
+} // namespace snmalloc::shim
+#endif
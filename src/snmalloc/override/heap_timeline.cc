@@ -0,0 +1,61 @@
+#include "export.h"
+#include "override.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#  include <stdlib.h>
+#  include <string.h>
+
+using namespace snmalloc;
+
+/**
+ * Recording of a heap timeline from a preloaded shim.  This is configured
+ * with environment variables, read when the library is loaded:
+ *
+ *  - `SNMALLOC_HEAP_TIMELINE`: The minimum interval between samples in ms.
+ *    Nothing is recorded if this is not set.
+ *  - `SNMALLOC_HEAP_TIMELINE_FILE`: The file to write the timeline to at
+ *    exit, as CSV if its name ends in `.csv` and as JSON otherwise.
+ */
+namespace
+{
+  char timeline_path[256];
+
+  TimelineFormat timeline_format = TimelineFormat::Json;
+
+  void write_heap_timeline()
+  {
+    HeapTimeline<Alloc::Config>::disable();
+    shim::write_file(timeline_path, [](auto& sink) {
+      HeapTimeline<Alloc::Config>::write(timeline_format, sink);
+    });
+  }
+
+  /**
+   * Read the configuration from the environment, and start recording if
+   * both the interval and the file are given.
+   */
+  void init_heap_timeline()
+  {
+    uint64_t interval_ms = 0;
+    if (!shim::getenv_decimal("SNMALLOC_HEAP_TIMELINE", interval_ms))
+      return;
+    if (!shim::getenv_path("SNMALLOC_HEAP_TIMELINE_FILE", timeline_path))
+    {
+      message<1024>("snmalloc: SNMALLOC_HEAP_TIMELINE_FILE is not set");
+      return;
+    }
+
+    auto length = strlen(timeline_path);
+    if ((length >= 4) && (strcmp(timeline_path + length - 4, ".csv") == 0))
+      timeline_format = TimelineFormat::Csv;
+
+    HeapTimeline<Alloc::Config>::enable(interval_ms);
+    atexit(&write_heap_timeline);
+  }
+
+  __attribute__((constructor)) void heap_timeline_constructor()
+  {
+    init_heap_timeline();
+  }
+} // namespace
+#endif
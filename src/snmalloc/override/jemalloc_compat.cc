@@ -78,6 +78,90 @@ namespace
      */
     allocm_err_not_moved = 2
   };
+
+  /**
+   * The `mallctl` names that are supported.  Each is given the
+   * Management Information Base (MIB) `{0, index}`, where `index` is its
+   * position in this table.  These are all read-only views of the calling
+   * thread's statistics, so are only available if `ThreadStatsEnabled`.
+   */
+  constexpr const char* mallctl_thread_names[] = {
+    "thread.allocated",
+    "thread.allocatedp",
+    "thread.deallocated",
+    "thread.deallocatedp"};
+
+  constexpr size_t mallctl_thread_count =
+    sizeof(mallctl_thread_names) / sizeof(mallctl_thread_names[0]);
+
+  /**
+   * Length of the MIB for each of the supported names.
+   */
+  constexpr size_t mallctl_mib_length = 2;
+
+  /**
+   * Find the index of `name` in `mallctl_thread_names`.  Returns
+   * `mallctl_thread_count` if the name is not supported.
+   */
+  size_t mallctl_lookup(const char* name)
+  {
+    if (!ThreadStatsEnabled || (name == nullptr))
+      return mallctl_thread_count;
+
+    for (size_t i = 0; i < mallctl_thread_count; i++)
+    {
+      if (strcmp(name, mallctl_thread_names[i]) == 0)
+        return i;
+    }
+    return mallctl_thread_count;
+  }
+
+  /**
+   * Copy `value` out to the caller following the `mallctl` conventions.
+   */
+  template<typename T>
+  int mallctl_read(T value, void* oldp, size_t* oldlenp)
+  {
+    if ((oldp == nullptr) || (oldlenp == nullptr))
+      return 0;
+
+    if (*oldlenp != sizeof(T))
+    {
+      memcpy(oldp, &value, bits::min(*oldlenp, sizeof(T)));
+      return EINVAL;
+    }
+
+    memcpy(oldp, &value, sizeof(T));
+    return 0;
+  }
+
+  /**
+   * Implementation of `mallctl` for the entry at `index` in
+   * `mallctl_thread_names`.
+   */
+  int mallctl_by_index(
+    size_t index, void* oldp, size_t* oldlenp, void* newp, size_t newlen)
+  {
+    if (index >= mallctl_thread_count)
+      return ENOENT;
+
+    // All of the supported names are read-only.
+    if ((newp != nullptr) || (newlen != 0))
+      return EPERM;
+
+    auto& stats = ThreadAlloc::get().get_thread_stats();
+    switch (index)
+    {
+      case 0:
+        return mallctl_read(stats.allocated, oldp, oldlenp);
+      case 1:
+        return mallctl_read(&stats.allocated, oldp, oldlenp);
+      case 2:
+        return mallctl_read(stats.deallocated, oldp, oldlenp);
+      default:
+        return mallctl_read(&stats.deallocated, oldp, oldlenp);
+    }
+  }
 } // namespace
 
 extern "C"
@@ -94,31 +178,59 @@ extern "C"
 
   /**
    * Jemalloc API provides a way of avoiding name lookup when calling
-   * `mallctl`.  For now, always return an error.
+   * `mallctl`.  Only the names in `mallctl_thread_names` are supported,
+   * anything else returns an error.
    */
-  int SNMALLOC_NAME_MANGLE(mallctlnametomib)(const char*, size_t*, size_t*)
+  int SNMALLOC_NAME_MANGLE(mallctlnametomib)(
+    const char* name, size_t* mibp, size_t* miblenp)
   {
-    return ENOENT;
+    auto index = mallctl_lookup(name);
+    if (index == mallctl_thread_count)
+      return ENOENT;
+
+    if ((mibp == nullptr) || (miblenp == nullptr))
+      return EINVAL;
+
+    if (*miblenp < mallctl_mib_length)
+      return ENOENT;
+
+    mibp[0] = 0;
+    mibp[1] = index;
+    *miblenp = mallctl_mib_length;
+    return 0;
   }
 
   /**
-   * Jemalloc API provides a generic entry point for various functions.  For
-   * now, this is always implemented to return an error.
+   * Jemalloc API provides a generic entry point for various functions.  This
+   * takes a MIB returned by `mallctlnametomib`.
    */
   int SNMALLOC_NAME_MANGLE(mallctlbymib)(
-    const size_t*, size_t, void*, size_t*, void*, size_t)
+    const size_t* mib,
+    size_t miblen,
+    void* oldp,
+    size_t* oldlenp,
+    void* newp,
+    size_t newlen)
   {
-    return ENOENT;
+    if (
+      !ThreadStatsEnabled || (mib == nullptr) ||
+      (miblen != mallctl_mib_length) || (mib[0] != 0))
+      return ENOENT;
+
+    return mallctl_by_index(mib[1], oldp, oldlenp, newp, newlen);
   }
 
   /**
-   * Jemalloc API provides a generic entry point for various functions.  For
-   * now, this is always implemented to return an error.
+   * Jemalloc API provides a generic entry point for various functions.  The
+   * per-thread `thread.allocated` and `thread.deallocated` counters, and
+   * pointers to them, are provided if snmalloc is built with
+   * `SNMALLOC_THREAD_STATS`.  Anything else returns an error.
    */
-  SNMALLOC_EXPORT int
-  SNMALLOC_NAME_MANGLE(mallctl)(const char*, void*, size_t*, void*, size_t)
+  SNMALLOC_EXPORT int SNMALLOC_NAME_MANGLE(mallctl)(
+    const char* name, void* oldp, size_t* oldlenp, void* newp, size_t newlen)
   {
-    return ENOENT;
+    return mallctl_by_index(
+      mallctl_lookup(name), oldp, oldlenp, newp, newlen);
   }
 
 #ifdef SNMALLOC_JEMALLOC3_EXPERIMENTAL
@@ -79,6 +79,8 @@ namespace snmalloc::libc
         ::memcpy(p, ptr, sz);
       }
       a.dealloc(ptr);
+      if (SNMALLOC_UNLIKELY(AllocHooks::active()))
+        AllocHooks::realloc(ptr, p, size);
     }
     else if (SNMALLOC_LIKELY(size == 0))
     {
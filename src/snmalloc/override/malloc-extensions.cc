@@ -2,6 +2,8 @@
 
 #include "../snmalloc.h"
 
+#include <errno.h>
+
 using namespace snmalloc;
 
 void get_malloc_info_v1(malloc_info_v1* stats)
@@ -11,3 +13,38 @@ void get_malloc_info_v1(malloc_info_v1* stats)
   stats->current_memory_usage = curr;
   stats->peak_memory_usage = peak;
 }
+
+int get_thread_alloc_stats_v1(thread_alloc_stats_v1* stats)
+{
+  if constexpr (!ThreadStatsEnabled)
+    return ENOENT;
+
+  auto& thread_stats = ThreadAlloc::get().get_thread_stats();
+  stats->allocated = thread_stats.allocated;
+  stats->deallocated = thread_stats.deallocated;
+  return 0;
+}
+
+uint8_t set_thread_alloc_tag_v1(uint8_t tag)
+{
+  return ThreadAlloc::get().set_tag(tag);
+}
+
+size_t get_alloc_tag_usage_v1(uint8_t tag)
+{
+  return AllocTags::get_live(tag);
+}
+
+void set_alloc_hooks_v1(const alloc_hooks_v1* hooks)
+{
+  if (hooks == nullptr)
+  {
+    AllocHooks::clear();
+    return;
+  }
+  AllocHooks::set(
+    {hooks->on_alloc,
+     hooks->on_dealloc,
+     hooks->on_realloc,
+     hooks->sample_interval});
+}
@@ -7,6 +7,9 @@
  * notes.
  */
 
+#include <stddef.h>
+#include <stdint.h>
+
 /**
  * Structure for returning memory used by snmalloc.
  *
@@ -33,3 +36,79 @@ struct malloc_info_v1
  * from snmalloc.
  */
 void get_malloc_info_v1(malloc_info_v1* stats);
+
+/**
+ * Structure for returning the memory allocated and deallocated by the
+ * calling thread.
+ */
+struct thread_alloc_stats_v1
+{
+  /**
+   * Total bytes allocated by this thread.  Objects are counted at their
+   * usable size.
+   */
+  uint64_t allocated;
+
+  /**
+   * Total bytes deallocated by this thread, including objects allocated by
+   * other threads.
+   */
+  uint64_t deallocated;
+};
+
+/**
+ * Populates a thread_alloc_stats_v1 structure for the calling thread.
+ * Returns 0 on success, or ENOENT if snmalloc was built without
+ * SNMALLOC_THREAD_STATS.
+ */
+int get_thread_alloc_stats_v1(thread_alloc_stats_v1* stats);
+
+/**
+ * Sets the allocation tag of the calling thread, and returns the previous
+ * tag.  Slabs and large allocations that the thread subsequently acquires
+ * from the backend are attributed to this tag until they are returned.  The
+ * initial tag of every thread is 0.
+ */
+uint8_t set_thread_alloc_tag_v1(uint8_t tag);
+
+/**
+ * Returns the bytes of slabs and large allocations currently attributed to
+ * `tag`.
+ */
+size_t get_alloc_tag_usage_v1(uint8_t tag);
+
+/**
+ * Callbacks for allocation events, for profilers.  Any may be null.
+ */
+struct alloc_hooks_v1
+{
+  /**
+   * Called with each large allocation, and with sampled small allocations.
+   */
+  void (*on_alloc)(void* p, size_t size);
+
+  /**
+   * Called with each large deallocation, and with sampled small
+   * deallocations.
+   */
+  void (*on_dealloc)(void* p, size_t size);
+
+  /**
+   * Called when realloc moves an object.
+   */
+  void (*on_realloc)(void* old_p, void* new_p, size_t size);
+
+  /**
+   * Report one in this many small allocations and deallocations per thread,
+   * or none if zero.  Small objects are only sampled if snmalloc was built
+   * with SNMALLOC_ALLOC_HOOK_SAMPLING.
+   */
+  size_t sample_interval;
+};
+
+/**
+ * Replaces the allocation hooks with copies of those in `hooks`, or removes
+ * them if `hooks` is null.  A hook that allocates or frees is not reported
+ * to the hooks.
+ */
+void set_alloc_hooks_v1(const alloc_hooks_v1* hooks);
@@ -115,6 +115,7 @@ extern "C"
   // This is required when RTL_DEEPBIND is used and the library is
   // LD_PRELOADed.
   // See https://github.com/microsoft/snmalloc/issues/595
+  // They are not called by snmalloc; profilers should use `AllocHooks`.
   SNMALLOC_EXPORT void (*SNMALLOC_NAME_MANGLE(__free_hook))(void* ptr) =
     &SNMALLOC_NAME_MANGLE(free);
   SNMALLOC_EXPORT void* (*SNMALLOC_NAME_MANGLE(__malloc_hook))(size_t size) =
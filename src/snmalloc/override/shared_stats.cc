@@ -0,0 +1,45 @@
+#include "export.h"
+#include "override.h"
+
+#if defined(__linux__)
+#  include <stdlib.h>
+
+using namespace snmalloc;
+
+/**
+ * Publication of allocator statistics into shared memory from a preloaded
+ * shim, for observation by `statsview`.  This is enabled by setting
+ * `SNMALLOC_SHARED_STATS` to the minimum interval between updates in ms, for
+ * instance `SNMALLOC_SHARED_STATS=100`.  The segment is removed at exit.
+ */
+namespace
+{
+  void disable_shared_stats()
+  {
+    SharedStats<Alloc::Config>::disable();
+  }
+
+  /**
+   * Read the interval from the environment, and enable publication if it is
+   * set.
+   */
+  void init_shared_stats()
+  {
+    uint64_t interval_ms = 0;
+    if (!shim::getenv_decimal("SNMALLOC_SHARED_STATS", interval_ms))
+      return;
+
+    if (!SharedStats<Alloc::Config>::enable(interval_ms))
+    {
+      message<1024>("snmalloc: Failed to create the shared statistics");
+      return;
+    }
+    atexit(&disable_shared_stats);
+  }
+
+  __attribute__((constructor)) void shared_stats_constructor()
+  {
+    init_shared_stats();
+  }
+} // namespace
+#endif
@@ -0,0 +1,102 @@
+#include "export.h"
+#include "override.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#  include <signal.h>
+
+using namespace snmalloc;
+
+/**
+ * Export of allocator statistics from a preloaded shim, for programs that
+ * cannot call the extension APIs themselves.  This is configured with
+ * environment variables, read when the library is loaded:
+ *
+ *  - `SNMALLOC_STATS_FILE`: The file to write the report to.  Nothing is
+ *    exported if this is not set.
+ *  - `SNMALLOC_STATS_FORMAT`: `json` (the default) or `prometheus`.
+ *  - `SNMALLOC_STATS_SIGNAL`: A signal number, or one of `USR1` and `USR2`,
+ *    on which to write the report, in addition to at exit.
+ *
+ * Each report replaces the contents of the file.  Reports are written
+ * without allocating from the heap that they describe.
+ */
+namespace
+{
+  char stats_path[256];
+
+  StatsFormat stats_format = StatsFormat::Json;
+
+  /**
+   * Parse the value of `SNMALLOC_STATS_SIGNAL`.  Returns 0 if it is not
+   * recognised.
+   */
+  int parse_signal(const char* s)
+  {
+    if (strcmp(s, "USR1") == 0 || strcmp(s, "SIGUSR1") == 0)
+      return SIGUSR1;
+    if (strcmp(s, "USR2") == 0 || strcmp(s, "SIGUSR2") == 0)
+      return SIGUSR2;
+
+    uint64_t sig = 0;
+    if (!shim::parse_decimal(s, sig) || (sig >= NSIG))
+      return 0;
+    return static_cast<int>(sig);
+  }
+
+  /**
+   * Write a report to the configured file.  This uses only
+   * async-signal-safe calls, so may be called from a signal handler.
+   */
+  void export_stats()
+  {
+    shim::write_file(stats_path, [](auto& sink) {
+      write_stats_report<Alloc::Config>(stats_format, sink);
+    });
+  }
+
+  void export_stats_on_signal(int)
+  {
+    export_stats();
+  }
+
+  /**
+   * Read the configuration from the environment, and register the exit and
+   * signal handlers if a file is given.
+   */
+  void init_stats_export()
+  {
+    if (!shim::getenv_path("SNMALLOC_STATS_FILE", stats_path))
+      return;
+
+    const char* format = getenv("SNMALLOC_STATS_FORMAT");
+    if ((format != nullptr) && (strcmp(format, "prometheus") == 0))
+      stats_format = StatsFormat::Prometheus;
+
+    const char* sig_name = getenv("SNMALLOC_STATS_SIGNAL");
+    if (sig_name != nullptr)
+    {
+      int sig = parse_signal(sig_name);
+      if (sig == 0)
+      {
+        message<1024>("snmalloc: SNMALLOC_STATS_SIGNAL is not a signal");
+      }
+      else
+      {
+        struct sigaction sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sa_handler = &export_stats_on_signal;
+        sa.sa_flags = SA_RESTART;
+        sigemptyset(&sa.sa_mask);
+        sigaction(sig, &sa, nullptr);
+      }
+    }
+
+    atexit(&export_stats);
+  }
+
+  __attribute__((constructor)) void stats_export_constructor()
+  {
+    init_stats_export();
+  }
+} // namespace
+#endif
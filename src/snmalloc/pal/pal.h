@@ -127,6 +127,26 @@ namespace snmalloc
     PAL::template zero<page_aligned>(p.unsafe_ptr(), sz);
   }
 
+  /**
+   * Fault in the pages of a range, and pin them if `pin` is set and the PAL
+   * supports it.  Returns false if pinning was requested and failed.
+   */
+  template<typename PAL>
+  static bool pal_prefault(void* p, size_t size, bool pin)
+  {
+    if constexpr (pal_supports<PinMemory, PAL>)
+    {
+      // Pinning also faults in the pages.
+      if (pin)
+        return PAL::pin(p, size);
+    }
+
+    for (size_t offset = 0; offset < size; offset += PAL::page_size)
+      *static_cast<volatile char*>(pointer_offset(p, offset)) = 0;
+
+    return !pin;
+  }
+
   static_assert(
     bits::is_pow2(OS_PAGE_SIZE), "OS_PAGE_SIZE must be a power of two");
   static_assert(
@@ -117,6 +117,36 @@ namespace snmalloc
                                      } -> ConceptSame<void>;
                                  };
 
+  /**
+   * Some PALs can pin memory so that it is not paged out.
+   */
+  template<typename PAL>
+  concept IsPAL_pin = requires(void* vp, std::size_t sz) {
+                        {
+                          PAL::pin(vp, sz)
+                          } noexcept -> ConceptSame<bool>;
+                      };
+
+  /**
+   * Some PALs can report a limit on the memory available to the process.
+   */
+  template<typename PAL>
+  concept IsPAL_memory_limit = requires() {
+                                 {
+                                   PAL::get_memory_limit()
+                                   } noexcept -> ConceptSame<size_t>;
+                               };
+
+  /**
+   * Some PALs can report that they could not commit memory.
+   */
+  template<typename PAL>
+  concept IsPAL_try_notify_using = requires(void* vp, std::size_t sz) {
+                                     {
+                                       PAL::try_notify_using(vp, sz)
+                                       } noexcept -> ConceptSame<bool>;
+                                   };
+
   template<typename PAL>
   concept IsPAL_get_entropy64 = requires() {
                                   {
@@ -140,6 +170,9 @@ namespace snmalloc
     IsPAL_tid<PAL> &&
     (!pal_supports<Entropy, PAL> || IsPAL_get_entropy64<PAL>) &&
     (!pal_supports<LowMemoryNotification, PAL> || IsPAL_mem_low_notify<PAL>) &&
+    (!pal_supports<PinMemory, PAL> || IsPAL_pin<PAL>) &&
+    (!pal_supports<MemoryLimit, PAL> || IsPAL_memory_limit<PAL>) &&
+    (!pal_supports<FallibleCommit, PAL> || IsPAL_try_notify_using<PAL>) &&
     (pal_supports<NoAllocation, PAL> ||
       ((!pal_supports<AlignedAllocation, PAL> || IsPAL_reserve_aligned<PAL>) &&
         IsPAL_reserve<PAL>));
@@ -55,6 +55,29 @@ namespace snmalloc
      * This Pal provides a millisecond time source
      */
     Time = (1 << 5),
+
+    /**
+     * This Pal can pin memory, so that it is resident and will not be paged
+     * out.  It must implement a `pin(void*, size_t)` method that returns a
+     * `bool` indicating whether the range could be pinned.
+     */
+    PinMemory = (1 << 6),
+
+    /**
+     * This Pal can report a limit on the memory available to the process,
+     * such as one imposed by a container.  It must implement a
+     * `get_memory_limit()` method that returns the limit in bytes, or zero if
+     * there is no limit.
+     */
+    MemoryLimit = (1 << 7),
+
+    /**
+     * This Pal can report that it could not commit memory.  It must
+     * implement a `try_notify_using(void*, size_t)` method that behaves as
+     * `notify_using<NoZero>`, but returns `false` rather than failing if the
+     * range could not be committed.
+     */
+    FallibleCommit = (1 << 8),
   };
 
   /**
@@ -25,9 +25,11 @@ namespace snmalloc
      * Bitmap of PalFeatures flags indicating the optional features that this
      * PAL supports.
      *
-     * We always make sure that linux has entropy support.
+     * We always make sure that linux has entropy support.  The memory limit
+     * is read from the cgroup v2 interface files.
      */
-    static constexpr uint64_t pal_features = PALPOSIX::pal_features | Entropy;
+    static constexpr uint64_t pal_features =
+      PALPOSIX::pal_features | Entropy | MemoryLimit;
 
     static constexpr size_t page_size =
       Aal::aal_name == PowerPC ? 0x10000 : PALPOSIX::page_size;
@@ -156,6 +158,56 @@ namespace snmalloc
       madvise(p, size, MADV_DODUMP);
     }
 
+    /**
+     * Set the directory containing the cgroup v2 `memory.max` and
+     * `memory.high` files read by `get_memory_limit`.  By default the
+     * process's own cgroup is found from `/proc/self/cgroup`, and it and its
+     * ancestors below `/sys/fs/cgroup` are read.  If a directory is set, only
+     * that directory is read.  The string must remain valid.
+     */
+    static void set_cgroup_path(const char* path) noexcept
+    {
+      cgroup_path.store(path, std::memory_order_release);
+    }
+
+    /**
+     * Return the smallest `memory.max` or `memory.high` of the cgroup and its
+     * ancestors, or zero if none is set or they cannot be read.  This does
+     * not allocate, so is safe to call from within the allocator.
+     */
+    static size_t get_memory_limit() noexcept
+    {
+      auto hold = KeepErrno();
+
+      char path[512];
+      size_t len;
+      auto dir = cgroup_path.load(std::memory_order_acquire);
+      if (dir != nullptr)
+      {
+        len = strlen(dir);
+        if (len >= sizeof(path))
+          return 0;
+        memcpy(path, dir, len);
+        return read_cgroup_limits(path, len, sizeof(path));
+      }
+
+      len = find_own_cgroup(path, sizeof(path));
+      if (len == 0)
+        return 0;
+
+      // The limits of every ancestor also apply.
+      size_t result = 0;
+      while (len > CGROUP_ROOT_LEN)
+      {
+        result = min_limit(result, read_cgroup_limits(path, len, sizeof(path)));
+        do
+        {
+          len--;
+        } while (path[len] != '/');
+      }
+      return result;
+    }
+
     static uint64_t get_entropy64()
     {
       // TODO: If the system call fails then the POSIX PAL calls libc
@@ -239,6 +291,118 @@ namespace snmalloc
       // its APIs are not exception-free.
       return dev_urandom();
     }
+
+  private:
+    /**
+     * The directory set by `set_cgroup_path`, or null to use the process's
+     * own cgroup.
+     */
+    static inline std::atomic<const char*> cgroup_path{nullptr};
+
+    static constexpr const char* CGROUP_ROOT = "/sys/fs/cgroup";
+    static constexpr size_t CGROUP_ROOT_LEN = 14;
+
+    /**
+     * The smaller of two limits, where zero means no limit.
+     */
+    static size_t min_limit(size_t a, size_t b) noexcept
+    {
+      if (a == 0)
+        return b;
+      if (b == 0)
+        return a;
+      return bits::min(a, b);
+    }
+
+    /**
+     * Write the directory of the process's cgroup v2 cgroup into `path`,
+     * which has room for `capacity` bytes, and return its length.  Returns
+     * zero if there is no cgroup v2 entry in `/proc/self/cgroup`.
+     */
+    static size_t find_own_cgroup(char* path, size_t capacity) noexcept
+    {
+      auto fd = open("/proc/self/cgroup", O_RDONLY | O_CLOEXEC);
+      if (fd < 0)
+        return 0;
+
+      char buffer[1024];
+      auto len = read(fd, buffer, sizeof(buffer));
+      close(fd);
+      if (len <= 0)
+        return 0;
+
+      // The cgroup v2 entry is the line `0::<path>`.
+      auto end = static_cast<size_t>(len);
+      for (size_t i = 0; i + 4 <= end;)
+      {
+        size_t eol = i;
+        while ((eol < end) && (buffer[eol] != '\n'))
+          eol++;
+
+        if ((buffer[i] == '0') && (buffer[i + 1] == ':') &&
+            (buffer[i + 2] == ':') && (buffer[i + 3] == '/'))
+        {
+          // Drop the trailing slash of the root cgroup.
+          auto cgroup_len = eol - (i + 3);
+          if (cgroup_len == 1)
+            cgroup_len = 0;
+          if (CGROUP_ROOT_LEN + cgroup_len >= capacity)
+            return 0;
+          memcpy(path, CGROUP_ROOT, CGROUP_ROOT_LEN);
+          memcpy(path + CGROUP_ROOT_LEN, buffer + i + 3, cgroup_len);
+          return CGROUP_ROOT_LEN + cgroup_len;
+        }
+        i = eol + 1;
+      }
+      return 0;
+    }
+
+    /**
+     * Return the smaller of `memory.max` and `memory.high` in the directory
+     * given by the first `len` bytes of `path`, which has room for
+     * `capacity` bytes.
+     */
+    static size_t
+    read_cgroup_limits(char* path, size_t len, size_t capacity) noexcept
+    {
+      return min_limit(
+        read_cgroup_limit(path, len, capacity, "memory.max"),
+        read_cgroup_limit(path, len, capacity, "memory.high"));
+    }
+
+    /**
+     * Read a cgroup v2 limit file in the directory given by the first `len`
+     * bytes of `path`.  Returns zero if the file cannot be read or contains
+     * `max`.
+     */
+    static size_t read_cgroup_limit(
+      char* path, size_t len, size_t capacity, const char* file) noexcept
+    {
+      auto file_len = strlen(file);
+      if (len + file_len + 2 > capacity)
+        return 0;
+      path[len] = '/';
+      memcpy(path + len + 1, file, file_len + 1);
+
+      auto fd = open(path, O_RDONLY | O_CLOEXEC);
+      if (fd < 0)
+        return 0;
+
+      char buffer[32];
+      auto read_len = read(fd, buffer, sizeof(buffer) - 1);
+      close(fd);
+      if (read_len <= 0)
+        return 0;
+
+      size_t result = 0;
+      for (ssize_t i = 0; i < read_len; i++)
+      {
+        if ((buffer[i] < '0') || (buffer[i] > '9'))
+          break;
+        result = (result * 10) + static_cast<size_t>(buffer[i] - '0');
+      }
+      return result;
+    }
   };
 } // namespace snmalloc
 #endif
@@ -122,10 +122,12 @@ namespace snmalloc
      * Bitmap of PalFeatures flags indicating the optional features that this
      * PAL supports.
      *
-     * POSIX systems are assumed to support lazy commit. The build system checks
+     * POSIX systems are assumed to support lazy commit and pinning memory with
+     * `mlock`, and to report a failure to commit. The build system checks
      * getentropy is available, only then this PAL supports Entropy.
      */
-    static constexpr uint64_t pal_features = LazyCommit | Time
+    static constexpr uint64_t pal_features =
+      LazyCommit | Time | PinMemory | FallibleCommit
 #if defined(SNMALLOC_PLATFORM_HAS_GETENTROPY)
       | Entropy
 #endif
@@ -243,6 +245,26 @@ namespace snmalloc
         zero<true>(p, size);
     }
 
+    /**
+     * As `notify_using<NoZero>`, but returns false if the pages could not be
+     * made accessible.  Lazy commit means that this can only fail if we have
+     * initially mapped the pages as PROT_NONE.
+     */
+    static bool try_notify_using(void* p, size_t size) noexcept
+    {
+      if constexpr (mitigations(pal_enforce_access))
+      {
+        auto hold = KeepErrno();
+        if (mprotect(p, size, PROT_READ | PROT_WRITE) != 0)
+          return false;
+      }
+
+      // Let the platform do anything else it needs to.  If the pages were
+      // protected, they already have these permissions.
+      OS::template notify_using<NoZero>(p, size);
+      return true;
+    }
+
     /**
      * Notify platform that we will be using these pages for reading.
      *
@@ -261,6 +283,19 @@ namespace snmalloc
       }
     }
 
+    /**
+     * Pin these pages, so that they are resident and will not be paged out.
+     * This faults in any pages that have not yet been touched.
+     *
+     * Returns false if the OS refused, for instance because this would exceed
+     * `RLIMIT_MEMLOCK`.
+     */
+    static bool pin(void* p, size_t size) noexcept
+    {
+      auto hold = KeepErrno();
+      return mlock(p, size) == 0;
+    }
+
     /**
      * OS specific function for zeroing memory.
      *
@@ -54,10 +54,11 @@ namespace snmalloc
   public:
     /**
      * Bitmap of PalFeatures flags indicating the optional features that this
-     * PAL supports.  This PAL supports low-memory notifications.
+     * PAL supports.  This PAL supports low-memory notifications, and reports
+     * a failure to commit.
      */
     static constexpr uint64_t pal_features = LowMemoryNotification | Entropy |
-      Time
+      Time | FallibleCommit
 #  if defined(PLATFORM_HAS_VIRTUALALLOC2) && !defined(USE_SYSTEMATIC_TESTING)
       | AlignedAllocation
 #  endif
@@ -155,6 +156,17 @@ namespace snmalloc
           "out of memory: {} ({}) could not be committed", p, size);
     }
 
+    /**
+     * As `notify_using<NoZero>`, but returns false if the pages could not be
+     * committed, for instance because the commit limit has been reached.
+     */
+    static bool try_notify_using(void* p, size_t size) noexcept
+    {
+      SNMALLOC_ASSERT(is_aligned_block<page_size>(p, size));
+
+      return VirtualAlloc(p, size, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+    }
+
     /// OS specific function for zeroing memory
     template<bool page_aligned = false>
     static void zero(void* p, size_t size) noexcept
@@ -0,0 +1,160 @@
+/**
+ * Allocation hooks test
+ * Check which events are reported to the hooks, through the C++ and C
+ * interfaces.
+ */
+#ifndef SNMALLOC_ALLOC_HOOK_SAMPLING
+#  define SNMALLOC_ALLOC_HOOK_SAMPLING
+#endif
+
+#include <test/setup.h>
+#include <vector>
+
+#define SNMALLOC_NAME_MANGLE(a) our_##a
+#include "../../../snmalloc/override/malloc-extensions.cc"
+#include "../../../snmalloc/override/malloc.cc"
+
+using namespace snmalloc;
+
+size_t allocs = 0;
+size_t deallocs = 0;
+size_t reallocs = 0;
+void* last_p = nullptr;
+size_t last_size = 0;
+
+void on_alloc(void* p, size_t size)
+{
+  allocs++;
+  last_p = p;
+  last_size = size;
+}
+
+void on_dealloc(void* p, size_t size)
+{
+  deallocs++;
+  last_p = p;
+  last_size = size;
+}
+
+void on_realloc(void*, void* p, size_t size)
+{
+  reallocs++;
+  last_p = p;
+  last_size = size;
+}
+
+void reset()
+{
+  allocs = 0;
+  deallocs = 0;
+  reallocs = 0;
+}
+
+void test_large()
+{
+  AllocHooks::set({&on_alloc, &on_dealloc, &on_realloc, 0});
+  reset();
+
+  // Large objects are always reported, small ones only when sampling.
+  size_t size = bits::one_at_bit(20);
+  void* p = our_malloc(size);
+  SNMALLOC_CHECK(allocs == 1);
+  SNMALLOC_CHECK(last_p == p);
+  SNMALLOC_CHECK(last_size == size);
+  our_free(p);
+  SNMALLOC_CHECK(deallocs == 1);
+  SNMALLOC_CHECK(last_p == p);
+  SNMALLOC_CHECK(last_size == size);
+
+  for (size_t i = 0; i < 10 * AllocHooks::IDLE_INTERVAL; i++)
+    our_free(our_malloc(48));
+  SNMALLOC_CHECK(allocs == 1);
+  SNMALLOC_CHECK(deallocs == 1);
+}
+
+void test_sampling()
+{
+  size_t interval = 10;
+  AllocHooks::set({&on_alloc, &on_dealloc, nullptr, interval});
+
+  // The thread may be part way through an idle countdown.
+  for (size_t i = 0; i < AllocHooks::IDLE_INTERVAL; i++)
+    our_free(our_malloc(48));
+  reset();
+
+  size_t count = 10000;
+  std::vector<void*> objects;
+  for (size_t i = 0; i < count; i++)
+    objects.push_back(our_malloc(48));
+  SNMALLOC_CHECK(allocs == count / interval);
+  SNMALLOC_CHECK(last_size == 48);
+  for (auto p : objects)
+    our_free(p);
+  SNMALLOC_CHECK(deallocs == count / interval);
+  SNMALLOC_CHECK(last_size == round_size(48));
+}
+
+void test_realloc()
+{
+  AllocHooks::set({nullptr, nullptr, &on_realloc, 0});
+  reset();
+
+  // Growing within the sizeclass does not move the object.
+  void* p = our_malloc(20);
+  p = our_realloc(p, 24);
+  SNMALLOC_CHECK(reallocs == 0);
+
+  p = our_realloc(p, 1000);
+  SNMALLOC_CHECK(reallocs == 1);
+  SNMALLOC_CHECK(last_p == p);
+  SNMALLOC_CHECK(last_size == 1000);
+  our_free(p);
+}
+
+void allocating_hook(void*, size_t)
+{
+  allocs++;
+  our_free(our_malloc(bits::one_at_bit(20)));
+}
+
+void test_reentrancy()
+{
+  AllocHooks::set({&allocating_hook, nullptr, nullptr, 0});
+  reset();
+
+  // The hook's own allocation is not reported.
+  our_free(our_malloc(bits::one_at_bit(20)));
+  SNMALLOC_CHECK(allocs == 1);
+}
+
+void test_c_api()
+{
+  alloc_hooks_v1 hooks{&on_alloc, &on_dealloc, nullptr, 0};
+  set_alloc_hooks_v1(&hooks);
+  reset();
+  our_free(our_malloc(bits::one_at_bit(20)));
+  SNMALLOC_CHECK(allocs == 1);
+  SNMALLOC_CHECK(deallocs == 1);
+
+  set_alloc_hooks_v1(nullptr);
+  SNMALLOC_CHECK(!AllocHooks::active());
+  our_free(our_malloc(bits::one_at_bit(20)));
+  SNMALLOC_CHECK(allocs == 1);
+  SNMALLOC_CHECK(deallocs == 1);
+}
+
+int main()
+{
+  setup();
+#ifdef SNMALLOC_PASS_THROUGH
+  // Events are not reported when passing through to the system allocator.
+  return 0;
+#else
+  test_large();
+  test_sampling();
+  test_realloc();
+  test_reentrancy();
+  test_c_api();
+  return 0;
+#endif
+}
@@ -0,0 +1,106 @@
+#ifdef SNMALLOC_PASS_THROUGH
+// Memory is not attributed to tags when passing through to the system
+// allocator.
+int main()
+{
+  return 0;
+}
+#else
+#  include <snmalloc/snmalloc.h>
+#  include <test/setup.h>
+#  include <thread>
+#  include <vector>
+
+using namespace snmalloc;
+
+static constexpr alloc_tag_t Small = 1;
+static constexpr alloc_tag_t Large = 2;
+static constexpr alloc_tag_t Remote = 3;
+
+void test_small()
+{
+  auto& a = ThreadAlloc::get();
+  auto other = AllocTags::get_live(0);
+
+  auto prev = a.set_tag(Small);
+  SNMALLOC_CHECK(prev == 0);
+  SNMALLOC_CHECK(a.get_tag() == Small);
+
+  std::vector<void*> objects;
+  for (size_t i = 0; i < 1000; i++)
+    objects.push_back(a.alloc(1024));
+  a.set_tag(prev);
+
+  // At least the live objects are attributed to the tag, in whole slabs.
+  auto live = AllocTags::get_live(Small);
+  SNMALLOC_CHECK(live >= 1000 * 1024);
+
+  // Allocations under another tag do not change this one.
+  void* p = a.alloc(1024 * 1024);
+  SNMALLOC_CHECK(AllocTags::get_live(Small) == live);
+  a.dealloc(p);
+
+  for (auto o : objects)
+    a.dealloc(o);
+
+  // Unused slabs may be cached by the allocator, but the tag never grows.
+  SNMALLOC_CHECK(AllocTags::get_live(Small) <= live);
+  SNMALLOC_CHECK(AllocTags::get_live(0) == other);
+}
+
+void test_large()
+{
+  auto& a = ThreadAlloc::get();
+  size_t size = bits::one_at_bit(22);
+  auto before = AllocTags::get_live(Large);
+
+  a.set_tag(Large);
+  void* p = a.alloc(size - 1);
+  a.set_tag(0);
+  SNMALLOC_CHECK(AllocTags::get_live(Large) == before + size);
+
+  a.dealloc(p);
+  SNMALLOC_CHECK(AllocTags::get_live(Large) == before);
+}
+
+void test_remote()
+{
+  // A large allocation freed by another thread is removed from the tag of the
+  // thread that allocated it, once the message has been processed.
+  auto& a = ThreadAlloc::get();
+  size_t size = bits::one_at_bit(21);
+  auto before = AllocTags::get_live(Remote);
+
+  a.set_tag(Remote);
+  void* p = a.alloc(size);
+  a.set_tag(0);
+  SNMALLOC_CHECK(AllocTags::get_live(Remote) == before + size);
+
+  // The queue holds back its last message, so send a second one after the
+  // chunk.
+  void* q = a.alloc(16);
+  std::thread t([p, q]() {
+    auto& b = ThreadAlloc::get();
+    b.set_tag(Large);
+    b.dealloc(p);
+    b.flush();
+    b.dealloc(q);
+    b.flush();
+  });
+  t.join();
+
+  // Process the message queue with a slow path allocation.
+  a.dealloc(a.alloc(size));
+  SNMALLOC_CHECK(AllocTags::get_live(Remote) == before);
+}
+
+int main()
+{
+  setup();
+
+  test_small();
+  test_large();
+  test_remote();
+  return 0;
+}
+#endif
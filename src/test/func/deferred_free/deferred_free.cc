@@ -0,0 +1,94 @@
+#ifdef SNMALLOC_PASS_THROUGH // This test depends on snmalloc internals
+int main()
+{
+  return 0;
+}
+#else
+#  include <atomic>
+#  include <iostream>
+#  include <snmalloc/snmalloc.h>
+#  include <test/setup.h>
+#  include <thread>
+
+using namespace snmalloc;
+
+static constexpr size_t COUNT = 100000;
+
+// Small enough that the freeing thread sometimes finds it full.
+DeferredFree<64> ring;
+
+std::atomic<bool> done{false};
+size_t fallbacks = 0;
+size_t drained = 0;
+
+void freeing_thread()
+{
+  auto& a = ThreadAlloc::get();
+  for (size_t i = 0; i < COUNT; i++)
+  {
+    auto p = a.alloc(16 + (i % 128));
+    SNMALLOC_CHECK(p != nullptr);
+    if (!ring.push(p))
+    {
+      fallbacks++;
+      a.dealloc(p);
+    }
+    // Give the helper a chance to run on machines with few cores.
+    if ((i % 32) == 0)
+      std::this_thread::yield();
+  }
+  done = true;
+}
+
+void helper_thread()
+{
+  while (true)
+  {
+    // Check for completion before draining, so that nothing pushed before
+    // completion is missed.
+    bool finished = done;
+    auto n = ring.drain();
+    drained += n;
+    if (finished && (n == 0))
+      break;
+    if (n == 0)
+      std::this_thread::yield();
+  }
+}
+
+int main()
+{
+  setup();
+
+  // A full ring refuses objects until it is drained.
+  {
+    auto& a = ThreadAlloc::get();
+    DeferredFree<64> local;
+    for (size_t i = 0; i < 64; i++)
+      SNMALLOC_CHECK(local.push(a.alloc(32)));
+    auto p = a.alloc(32);
+    SNMALLOC_CHECK(!local.push(p));
+    SNMALLOC_CHECK(local.drain() == 64);
+    SNMALLOC_CHECK(local.drain() == 0);
+    SNMALLOC_CHECK(local.push(p));
+    SNMALLOC_CHECK(local.drain() == 1);
+
+    // Objects left in the ring are freed when it is destroyed.
+    SNMALLOC_CHECK(local.push(a.alloc(32)));
+    SNMALLOC_CHECK(local.push(a.alloc(64)));
+  }
+
+  std::thread helper(helper_thread);
+  std::thread freeing(freeing_thread);
+  freeing.join();
+  helper.join();
+
+  std::cout << "Drained " << drained << ", freed directly " << fallbacks
+            << std::endl;
+  SNMALLOC_CHECK(drained + fallbacks == COUNT);
+
+  // The objects freed by the helper have been sent back to their owner.
+  snmalloc::debug_check_empty<Alloc::Config>();
+  return 0;
+}
+#endif
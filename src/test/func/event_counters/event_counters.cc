@@ -0,0 +1,79 @@
+#define SNMALLOC_EVENT_COUNTERS
+
+#ifdef SNMALLOC_PASS_THROUGH
+// Events are not counted when passing through to the system allocator.
+int main()
+{
+  return 0;
+}
+#else
+#  include <snmalloc/snmalloc.h>
+#  include <test/setup.h>
+#  include <thread>
+#  include <vector>
+
+using namespace snmalloc;
+
+uint64_t get(Event e)
+{
+  EventCounters counters;
+  get_event_counters<StandardConfig>(counters);
+  return counters.get(e);
+}
+
+int main()
+{
+  setup();
+
+  auto& a = ThreadAlloc::get();
+  auto before_slow = get(Event::SmallAllocSlow);
+  auto before_dealloc = get(Event::DeallocLocalSlow);
+
+  // Fill and free many slabs.
+  std::vector<void*> objects;
+  for (size_t i = 0; i < 10000; i++)
+    objects.push_back(a.alloc(256));
+  for (auto p : objects)
+    a.dealloc(p);
+  objects.clear();
+
+  SNMALLOC_CHECK(get(Event::SmallAllocSlow) > before_slow);
+  SNMALLOC_CHECK(get(Event::DeallocLocalSlow) > before_dealloc);
+
+  // Free objects from another thread, and process the messages.
+  auto before_messages = get(Event::MessageQueue);
+  auto before_posts = get(Event::RemotePostRound);
+  for (size_t i = 0; i < 100; i++)
+    objects.push_back(a.alloc(64));
+  std::thread t([&objects]() {
+    auto& b = ThreadAlloc::get();
+    for (auto p : objects)
+    {
+      b.dealloc(p);
+      b.flush();
+    }
+  });
+  t.join();
+  a.dealloc(a.alloc(bits::one_at_bit(20)));
+
+  SNMALLOC_CHECK(get(Event::RemotePostRound) > before_posts);
+  SNMALLOC_CHECK(get(Event::MessageQueue) > before_messages);
+
+  // A large allocation beyond the thread's cache is committed and
+  // decommitted.
+  // These are counted against the allocator, not the shared backend
+  // counters.
+  auto before_commit = get(Event::PalCommit);
+  auto before_decommit = get(Event::PalDecommit);
+  auto before_shared = EventCounters::backend().get(Event::PalCommit);
+  a.dealloc(a.alloc(bits::one_at_bit(26)));
+  SNMALLOC_CHECK(get(Event::PalCommit) > before_commit);
+  SNMALLOC_CHECK(get(Event::PalDecommit) > before_decommit);
+  SNMALLOC_CHECK(get(Event::BuddyRefill) > 0);
+  SNMALLOC_CHECK(
+    EventCounters::backend().get(Event::PalCommit) == before_shared);
+
+  print_event_counters<StandardConfig>();
+  return 0;
+}
+#endif
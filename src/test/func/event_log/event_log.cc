@@ -0,0 +1,133 @@
+#ifndef SNMALLOC_EVENT_LOG
+#  define SNMALLOC_EVENT_LOG
+#endif
+
+#ifdef SNMALLOC_PASS_THROUGH
+// Events are not recorded when passing through to the system allocator.
+int main()
+{
+  return 0;
+}
+#else
+#  include <snmalloc/snmalloc.h>
+#  include <string.h>
+#  include <test/setup.h>
+#  include <thread>
+#  include <vector>
+
+using namespace snmalloc;
+
+/**
+ * The decoded contents of a log.
+ */
+struct Log
+{
+  EventLog::Header header;
+  std::vector<EventLog::RingHeader> rings;
+  std::vector<std::vector<LogRecord>> records;
+};
+
+Log read_log()
+{
+  std::vector<char> bytes;
+  auto sink = [&bytes](const void* data, size_t length) {
+    auto* p = static_cast<const char*>(data);
+    bytes.insert(bytes.end(), p, p + length);
+  };
+  EventLog::write(sink);
+
+  Log log;
+  size_t offset = 0;
+  auto read = [&](void* out, size_t length) {
+    SNMALLOC_CHECK(offset + length <= bytes.size());
+    memcpy(out, bytes.data() + offset, length);
+    offset += length;
+  };
+
+  read(&log.header, sizeof(log.header));
+  for (size_t i = 0; i < log.header.rings; i++)
+  {
+    EventLog::RingHeader rh;
+    read(&rh, sizeof(rh));
+    log.rings.push_back(rh);
+    std::vector<LogRecord> records(rh.count);
+    read(records.data(), rh.count * sizeof(LogRecord));
+    log.records.push_back(records);
+  }
+  SNMALLOC_CHECK(offset == bytes.size());
+  return log;
+}
+
+size_t count(const Log& log, LogEvent e)
+{
+  size_t result = 0;
+  for (auto& records : log.records)
+    for (auto& r : records)
+      if (r.event == e)
+        result++;
+  return result;
+}
+
+int main()
+{
+  setup();
+
+  auto& a = ThreadAlloc::get();
+  std::vector<void*> objects;
+  for (size_t i = 0; i < 1000; i++)
+    objects.push_back(a.alloc(256));
+  auto* large = a.alloc(bits::one_at_bit(20));
+
+  // Free from another thread, so that it records into a second ring.
+  std::thread t([&objects]() {
+    auto& b = ThreadAlloc::get();
+    for (auto p : objects)
+      b.dealloc(p);
+    b.flush();
+  });
+  t.join();
+  a.dealloc(large);
+
+  auto log = read_log();
+  SNMALLOC_CHECK(log.header.magic == EventLog::MAGIC);
+  SNMALLOC_CHECK(log.header.record_size == sizeof(LogRecord));
+  SNMALLOC_CHECK(log.header.rings >= 2);
+
+  SNMALLOC_CHECK(count(log, LogEvent::SmallAllocSlow) != 0);
+  SNMALLOC_CHECK(count(log, LogEvent::LargeAlloc) == 1);
+  SNMALLOC_CHECK(count(log, LogEvent::LargeDealloc) == 1);
+  SNMALLOC_CHECK(count(log, LogEvent::RemoteDealloc) == objects.size());
+
+  // Each ring is in the order in which its thread recorded.
+  for (auto& records : log.records)
+    for (size_t i = 1; i < records.size(); i++)
+      SNMALLOC_CHECK(records[i - 1].tick <= records[i].tick);
+
+  // The large allocation's payload is its address and size.
+  for (auto& records : log.records)
+    for (auto& r : records)
+      if (r.event == LogEvent::LargeAlloc)
+      {
+        SNMALLOC_CHECK(r.payload[0] == address_cast(large));
+        SNMALLOC_CHECK(r.payload[1] == bits::one_at_bit(20));
+      }
+
+  // Rings are released when threads exit, so more threads than there are
+  // rings can record, one after another.
+  for (size_t i = 0; i < 2 * EventLog::MAX_RINGS; i++)
+  {
+    std::thread u([]() {
+      auto& c = ThreadAlloc::get();
+      c.dealloc(c.alloc(bits::one_at_bit(20)));
+    });
+    u.join();
+  }
+  log = read_log();
+  SNMALLOC_CHECK(log.header.dropped == 0);
+  SNMALLOC_CHECK(log.header.rings < EventLog::MAX_RINGS);
+  SNMALLOC_CHECK(
+    count(log, LogEvent::LargeAlloc) == 1 + 2 * EventLog::MAX_RINGS);
+
+  return 0;
+}
+#endif
@@ -0,0 +1,97 @@
+#include "test/setup.h"
+
+#include <iostream>
+#include <snmalloc/backend/fixedglobalconfig.h>
+#include <snmalloc/snmalloc.h>
+#include <thread>
+#include <vector>
+
+using namespace snmalloc;
+
+static constexpr size_t SHARDS = 4;
+
+using CustomGlobals = FixedRangeConfig<PALNoAlloc<DefaultPal>, void, SHARDS>;
+using FixedAlloc = LocalAllocator<CustomGlobals>;
+
+void* base;
+size_t size;
+
+void check_in_region(void* p)
+{
+  SNMALLOC_CHECK(
+    (address_cast(p) >= address_cast(base)) &&
+    (address_cast(p) < address_cast(base) + size));
+}
+
+/**
+ * Allocate and free objects of a range of sizes, from several threads at
+ * once.
+ */
+void churn(size_t id)
+{
+  FixedAlloc a;
+  std::vector<void*> objects;
+  for (size_t round = 0; round < 20; round++)
+  {
+    for (size_t i = 0; i < 200; i++)
+    {
+      size_t object_size = (i % 10 == id) ? bits::one_at_bit(18) : 128;
+      auto p = a.alloc(object_size);
+      SNMALLOC_CHECK(p != nullptr);
+      check_in_region(p);
+      objects.push_back(p);
+    }
+    for (auto p : objects)
+      a.dealloc(p);
+    objects.clear();
+  }
+  a.teardown();
+}
+
+int main()
+{
+#ifndef SNMALLOC_PASS_THROUGH // Depends on snmalloc specific features
+  setup();
+
+  size = bits::one_at_bit(26);
+  base = DefaultPal::reserve(size);
+  DefaultPal::notify_using<NoZero>(base, size);
+  std::cout << "Allocated region " << base << " - "
+            << pointer_offset(base, size) << std::endl;
+
+  CustomGlobals::init(nullptr, base, size);
+  FixedAlloc a;
+
+  // The largest object is a stripe, which is half of each shard's share of
+  // the heap after the pagemap has been taken from it.
+  size_t stripe = (size / SHARDS) / 2;
+  auto big = a.alloc(stripe);
+  SNMALLOC_CHECK(big != nullptr);
+  check_in_region(big);
+  SNMALLOC_CHECK(a.alloc(stripe * 2) == nullptr);
+  a.dealloc(big);
+
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < SHARDS; i++)
+    threads.emplace_back(churn, i);
+  for (auto& t : threads)
+    t.join();
+
+  // One allocator can use the whole heap, by stealing from the other
+  // shards.
+  size_t count = 0;
+  while (true)
+  {
+    auto p = a.alloc(bits::one_at_bit(16));
+    if (p == nullptr)
+      break;
+    check_in_region(p);
+    count += bits::one_at_bit(16);
+  }
+  std::cout << "Total allocated: " << count << " out of " << size
+            << std::endl;
+  SNMALLOC_CHECK(count > size / 2);
+
+  a.teardown();
+#endif
+}
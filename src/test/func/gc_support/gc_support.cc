@@ -0,0 +1,193 @@
+/**
+ * Conservative garbage collector support test
+ * Check the allocated-object bitmap and the classification of interior
+ * pointers.
+ */
+#ifdef SNMALLOC_PASS_THROUGH // This test depends on snmalloc internals
+int main()
+{
+  return 0;
+}
+#else
+#  include <snmalloc/snmalloc.h>
+#  include <test/setup.h>
+#  include <thread>
+#  include <vector>
+
+using namespace snmalloc;
+
+static constexpr size_t WORDS = Alloc::ALLOCATED_BITMAP_WORDS;
+
+bool is_set(const uint64_t* bitmap, size_t i)
+{
+  return ((bitmap[i / 64] >> (i % 64)) & 1) != 0;
+}
+
+/**
+ * Check that the objects in `objects` are reported as allocated, and those
+ * in `freed` as free.
+ */
+void check_bitmap(
+  const std::vector<void*>& objects, const std::vector<void*>& freed)
+{
+  auto& a = ThreadAlloc::get();
+  auto sc = size_to_sizeclass(48);
+  size_t size = sizeclass_to_size(sc);
+  size_t slab_size = sizeclass_to_slab_size(sc);
+
+  auto check = [&](void* p, bool allocated) {
+    uint64_t bitmap[WORDS];
+    size_t count = a.allocated_objects(p, bitmap);
+    SNMALLOC_CHECK(count == sizeclass_to_slab_object_count(sc));
+    size_t index = (address_cast(p) % slab_size) / size;
+    SNMALLOC_CHECK(is_set(bitmap, index) == allocated);
+  };
+
+  for (auto p : objects)
+    check(p, true);
+  for (auto p : freed)
+    check(p, false);
+}
+
+void test_bitmap()
+{
+  auto& a = ThreadAlloc::get();
+  std::vector<void*> objects;
+  std::vector<void*> freed;
+  for (size_t i = 0; i < 3000; i++)
+    objects.push_back(a.alloc(48));
+
+  // Objects freed locally are on the slabs' free lists, or on the free list
+  // that the next allocation will take from.
+  for (size_t i = 0; i < objects.size(); i += 3)
+  {
+    a.dealloc(objects[i]);
+    freed.push_back(objects[i]);
+    objects[i] = objects.back();
+    objects.pop_back();
+  }
+  check_bitmap(objects, freed);
+
+  // Objects freed by a thread that has exited have been sent back to this
+  // allocator.  The last object sent is held in the message queue until
+  // another arrives, so send one more that is not checked.
+  std::vector<void*> remote(objects.begin(), objects.begin() + 100);
+  objects.erase(objects.begin(), objects.begin() + 100);
+  std::thread([&remote]() {
+    for (auto p : remote)
+      ThreadAlloc::get().dealloc(p);
+  }).join();
+  void* last = objects.front();
+  objects.erase(objects.begin());
+  std::thread([last]() { ThreadAlloc::get().dealloc(last); }).join();
+  check_bitmap(objects, remote);
+
+  for (auto p : objects)
+    a.dealloc(p);
+}
+
+void test_large()
+{
+  auto& a = ThreadAlloc::get();
+  size_t size = bits::one_at_bit(20);
+  auto p = static_cast<char*>(a.alloc(size));
+
+  uint64_t bitmap[WORDS];
+  SNMALLOC_CHECK(a.allocated_objects(p + size / 2, bitmap) == 1);
+  SNMALLOC_CHECK(bitmap[0] == 1);
+  a.dealloc(p);
+
+  // Memory that is not from this allocator is not reported.
+  int local = 0;
+  SNMALLOC_CHECK(a.allocated_objects(&local, bitmap) == 0);
+  SNMALLOC_CHECK(a.allocated_objects(nullptr, bitmap) == 0);
+}
+
+void test_pool_walk()
+{
+  auto& a = ThreadAlloc::get();
+  std::vector<void*> objects;
+  std::vector<void*> freed;
+
+  // A thread that has exited leaves its allocator quiesced in the pool,
+  // still owning the objects it did not free.
+  std::thread([&objects, &freed]() {
+    auto& b = ThreadAlloc::get();
+    for (size_t i = 0; i < 500; i++)
+      objects.push_back(b.alloc(48));
+    for (size_t i = 0; i < objects.size(); i += 2)
+    {
+      b.dealloc(objects[i]);
+      freed.push_back(objects[i]);
+      objects[i] = objects.back();
+      objects.pop_back();
+    }
+  }).join();
+
+  auto sc = size_to_sizeclass(48);
+  size_t size = sizeclass_to_size(sc);
+  size_t slab_size = sizeclass_to_slab_size(sc);
+  auto check = [&](void* p, bool allocated) {
+    uint64_t bitmap[WORDS];
+    // This thread's allocator does not own the slab.
+    SNMALLOC_CHECK(a.allocated_objects(p, bitmap) == 0);
+    size_t count = allocated_objects<Alloc::Config>(p, bitmap);
+    SNMALLOC_CHECK(count == sizeclass_to_slab_object_count(sc));
+    size_t index = (address_cast(p) % slab_size) / size;
+    SNMALLOC_CHECK(is_set(bitmap, index) == allocated);
+  };
+
+  for (auto p : objects)
+    check(p, true);
+  for (auto p : freed)
+    check(p, false);
+
+  for (auto p : objects)
+    a.dealloc(p);
+}
+
+void test_classify()
+{
+  auto& a = ThreadAlloc::get();
+  std::vector<char*> objects;
+  for (size_t size = 16; size < bits::one_at_bit(22); size = size * 3 + 1)
+    objects.push_back(static_cast<char*>(a.alloc(size)));
+
+  // Pointers to the start, middle and last byte of each object, followed by
+  // some that are not to the heap.
+  int local = 0;
+  std::vector<void*> ptrs;
+  for (auto p : objects)
+  {
+    size_t size = a.alloc_size(p);
+    ptrs.push_back(p);
+    ptrs.push_back(p + size / 2);
+    ptrs.push_back(p + size - 1);
+  }
+  ptrs.push_back(&local);
+  ptrs.push_back(nullptr);
+
+  a.classify(ptrs.data(), ptrs.size());
+
+  for (size_t i = 0; i < objects.size(); i++)
+  {
+    for (size_t j = 0; j < 3; j++)
+      SNMALLOC_CHECK(ptrs[i * 3 + j] == objects[i]);
+  }
+  SNMALLOC_CHECK(ptrs[objects.size() * 3] == nullptr);
+  SNMALLOC_CHECK(ptrs[objects.size() * 3 + 1] == nullptr);
+
+  for (auto p : objects)
+    a.dealloc(p);
+}
+
+int main()
+{
+  setup();
+  test_bitmap();
+  test_large();
+  test_pool_walk();
+  test_classify();
+  return 0;
+}
+#endif
@@ -0,0 +1,176 @@
+#ifdef SNMALLOC_PASS_THROUGH // This test depends on snmalloc internals
+int main()
+{
+  return 0;
+}
+#else
+#  include <atomic>
+#  include <iostream>
+#  include <snmalloc/snmalloc.h>
+#  include <test/setup.h>
+#  include <thread>
+#  include <vector>
+
+using namespace snmalloc;
+
+size_t current_usage()
+{
+  return Alloc::Config::Backend::get_current_usage();
+}
+
+size_t handler_calls = 0;
+
+bool refuse(size_t)
+{
+  handler_calls++;
+  return false;
+}
+
+bool raise_limit(size_t size)
+{
+  handler_calls++;
+  // The handler is called once per failure, and the backend may need more
+  // than `size` to refill its caches, so raise the limit generously.
+  HeapLimit::set_limit(HeapLimit::get_limit() + 4 * size);
+  return true;
+}
+
+void test_limit_enforced()
+{
+  std::cout << "test_limit_enforced" << std::endl;
+  auto& a = ThreadAlloc::get();
+
+  size_t budget = bits::one_at_bit(24);
+  size_t object_size = bits::one_at_bit(20);
+  handler_calls = 0;
+  set_heap_limit<Alloc::Config>(current_usage() + budget, &refuse);
+
+  std::vector<void*> allocs;
+  while (true)
+  {
+    errno = 0;
+    auto p = a.alloc(object_size);
+    if (p == nullptr)
+    {
+      SNMALLOC_CHECK(errno == ENOMEM);
+      break;
+    }
+    allocs.push_back(p);
+    SNMALLOC_CHECK(allocs.size() * object_size <= budget);
+  }
+
+  std::cout << "Allocated " << allocs.size() << " objects of " << object_size
+            << " within a budget of " << budget << std::endl;
+  SNMALLOC_CHECK(handler_calls != 0);
+  SNMALLOC_CHECK(allocs.size() * object_size >= budget / 2);
+
+  for (auto p : allocs)
+    a.dealloc(p);
+
+  // Freed memory can be reused within the limit.
+  auto p = a.alloc(object_size);
+  SNMALLOC_CHECK(p != nullptr);
+  a.dealloc(p);
+
+  set_heap_limit<Alloc::Config>(0);
+}
+
+void test_handler_retry()
+{
+  std::cout << "test_handler_retry" << std::endl;
+  auto& a = ThreadAlloc::get();
+
+  handler_calls = 0;
+  set_heap_limit<Alloc::Config>(current_usage(), &raise_limit);
+
+  // The handler raises the limit, so every allocation succeeds.
+  size_t object_size = bits::one_at_bit(22);
+  std::vector<void*> allocs;
+  for (size_t i = 0; i < 8; i++)
+  {
+    auto p = a.alloc(object_size);
+    SNMALLOC_CHECK(p != nullptr);
+    allocs.push_back(p);
+  }
+  SNMALLOC_CHECK(handler_calls != 0);
+
+  for (auto p : allocs)
+    a.dealloc(p);
+
+  set_heap_limit<Alloc::Config>(0);
+}
+
+void test_purge_unused()
+{
+  std::cout << "test_purge_unused" << std::endl;
+
+  // Leave memory cached in an allocator that returns to the pool when the
+  // thread exits.
+  std::thread t([]() {
+    auto& a = ThreadAlloc::get();
+    std::vector<void*> allocs;
+    for (size_t i = 0; i < 16; i++)
+      allocs.push_back(a.alloc(bits::one_at_bit(16)));
+    for (auto p : allocs)
+      a.dealloc(p);
+  });
+  t.join();
+
+  auto before = current_usage();
+  purge_unused<Alloc::Config>();
+  auto after = current_usage();
+  std::cout << "Usage before purge " << before << " after " << after
+            << std::endl;
+  SNMALLOC_CHECK(after < before);
+}
+
+void test_purge_live()
+{
+  std::cout << "test_purge_live" << std::endl;
+
+  // Leave memory cached in an allocator that is still in use.
+  std::atomic<int> step{0};
+  std::thread t([&]() {
+    auto& a = ThreadAlloc::get();
+    std::vector<void*> allocs;
+    for (size_t i = 0; i < 16; i++)
+      allocs.push_back(a.alloc(bits::one_at_bit(16)));
+    for (auto p : allocs)
+      a.dealloc(p);
+
+    step = 1;
+    while (step != 2)
+      std::this_thread::yield();
+
+    // The next allocation slow path returns the cached memory.
+    a.dealloc(a.alloc(bits::one_at_bit(16)));
+    step = 3;
+  });
+
+  while (step != 1)
+    std::this_thread::yield();
+  auto before = current_usage();
+  MemoryPressure::purge();
+  step = 2;
+  while (step != 3)
+    std::this_thread::yield();
+  auto after = current_usage();
+  t.join();
+
+  std::cout << "Usage before purge " << before << " after " << after
+            << std::endl;
+  SNMALLOC_CHECK(after < before);
+}
+
+int main()
+{
+  setup();
+
+  test_limit_enforced();
+  test_handler_retry();
+  test_purge_unused();
+  test_purge_live();
+
+  return 0;
+}
+#endif
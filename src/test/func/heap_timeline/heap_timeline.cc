@@ -0,0 +1,97 @@
+#ifdef SNMALLOC_PASS_THROUGH
+// The timeline depends on snmalloc internals.
+int main()
+{
+  return 0;
+}
+#else
+#  include <snmalloc/snmalloc.h>
+#  include <string>
+#  include <test/setup.h>
+#  include <vector>
+
+using namespace snmalloc;
+
+using Timeline = HeapTimeline<Alloc::Config>;
+
+std::string write(TimelineFormat format)
+{
+  std::string out;
+  auto sink = [&out](const char* data, size_t length) {
+    out.append(data, length);
+  };
+  Timeline::write(format, sink);
+  return out;
+}
+
+size_t count_lines(const std::string& s)
+{
+  size_t lines = 0;
+  for (auto c : s)
+    lines += (c == '\n') ? 1 : 0;
+  return lines;
+}
+
+int main()
+{
+  setup();
+
+  auto& a = ThreadAlloc::get();
+  a.dealloc(a.alloc(1));
+  SNMALLOC_CHECK(Timeline::get_taken() == 0);
+  SNMALLOC_CHECK(count_lines(write(TimelineFormat::Csv)) == 1);
+
+  // The backend's buddy allocators hold the rest of the memory that they
+  // refilled with to serve the allocation and its metadata.
+  size_t cached = 0;
+  for (size_t i = 0; i < NUM_BUDDY_LAYERS; i++)
+    cached += BuddyCacheStats::get(static_cast<BuddyLayer>(i));
+  SNMALLOC_CHECK(cached != 0);
+
+  Timeline::record();
+  std::vector<void*> objects;
+  for (size_t i = 0; i < 1000; i++)
+    objects.push_back(a.alloc(48));
+  Timeline::record();
+  SNMALLOC_CHECK(Timeline::get_taken() == 2);
+
+  auto csv = write(TimelineFormat::Csv);
+  printf("%s", csv.c_str());
+  SNMALLOC_CHECK(count_lines(csv) == 3);
+  SNMALLOC_CHECK(
+    csv.find("time_ms,committed_bytes,large_bytes,global_buddy_bytes,") == 0);
+  SNMALLOC_CHECK(csv.find(",slab_bytes_48,") != std::string::npos);
+
+  auto json = write(TimelineFormat::Json);
+  SNMALLOC_CHECK(json.find("\"sizeclasses\": [") != std::string::npos);
+  SNMALLOC_CHECK(json.find("{\"time_ms\": ") != std::string::npos);
+  SNMALLOC_CHECK(json.find("\"slab_bytes\": [") != std::string::npos);
+
+  // Once enabled, samples are taken from the slow paths.  With a zero
+  // interval, that is whenever they read the clock.
+  Timeline::enable(0);
+  auto taken = Timeline::get_taken();
+  auto start = DefaultPal::time_in_ms();
+  while ((Timeline::get_taken() == taken) &&
+         (DefaultPal::time_in_ms() - start < 10000))
+  {
+    std::vector<void*> batch;
+    for (size_t i = 0; i < 10000; i++)
+      batch.push_back(a.alloc(256));
+    for (auto p : batch)
+      a.dealloc(p);
+  }
+  SNMALLOC_CHECK(Timeline::get_taken() != taken);
+  Timeline::disable();
+
+  // The ring keeps only the most recent samples.
+  while (Timeline::get_taken() <= Timeline::CAPACITY)
+    Timeline::record();
+  SNMALLOC_CHECK(
+    count_lines(write(TimelineFormat::Csv)) == Timeline::CAPACITY + 1);
+
+  for (auto p : objects)
+    a.dealloc(p);
+  return 0;
+}
+#endif
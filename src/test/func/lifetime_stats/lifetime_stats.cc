@@ -0,0 +1,84 @@
+#ifndef SNMALLOC_LIFETIME_STATS
+#  define SNMALLOC_LIFETIME_STATS
+#endif
+
+#ifdef SNMALLOC_PASS_THROUGH
+// Lifetimes are not sampled when passing through to the system allocator.
+int main()
+{
+  return 0;
+}
+#else
+#  include <snmalloc/snmalloc.h>
+#  include <string>
+#  include <test/setup.h>
+#  include <vector>
+
+using namespace snmalloc;
+
+uint64_t total(size_t index)
+{
+  uint64_t count = 0;
+  for (size_t b = 0; b < LifetimeStats::BUCKETS; b++)
+    count += LifetimeStats::get_count(index, b);
+  return count;
+}
+
+int main()
+{
+  setup();
+
+  static constexpr size_t size = 48;
+  static constexpr size_t samples = 20;
+  static constexpr size_t min_lifetime_bits = 20;
+  auto sizeclass = size_to_sizeclass(size);
+  SNMALLOC_CHECK(total(sizeclass) == 0);
+
+  auto& a = ThreadAlloc::get();
+  std::vector<void*> objects;
+  objects.reserve(LifetimeStats::SAMPLE_INTERVAL * samples);
+  for (size_t i = 0; i < LifetimeStats::SAMPLE_INTERVAL * samples; i++)
+    objects.push_back(a.alloc(size));
+
+  // Keep every object alive for at least 2^min_lifetime_bits ticks.
+  auto start = Aal::tick();
+  while (Aal::tick() - start < bits::one_at_bit(min_lifetime_bits))
+    Aal::pause();
+  for (auto* p : objects)
+    a.dealloc(p);
+
+  // One in SAMPLE_INTERVAL allocations is sampled, and all of those since
+  // the vector was reserved were of `size`.
+  auto count = total(sizeclass);
+  SNMALLOC_CHECK(count >= samples - 1);
+  SNMALLOC_CHECK(count <= samples);
+  SNMALLOC_CHECK(LifetimeStats::get_dropped() == 0);
+  for (size_t b = 0; b < min_lifetime_bits; b++)
+    SNMALLOC_CHECK(LifetimeStats::get_count(sizeclass, b) == 0);
+  SNMALLOC_CHECK(
+    LifetimeStats::get_sum(sizeclass) >=
+    count * bits::one_at_bit(min_lifetime_bits));
+
+  // Objects that were not sampled do not add to the histograms.
+  a.dealloc(a.alloc(size));
+  SNMALLOC_CHECK(total(sizeclass) == count);
+
+  std::string report;
+  auto sink = [&report](const char* data, size_t length) {
+    report.append(data, length);
+  };
+  write_stats_report<Alloc::Config>(StatsFormat::Json, sink);
+  SNMALLOC_CHECK(
+    report.find("\"lifetime_sample_interval\": 10000") != std::string::npos);
+  SNMALLOC_CHECK(
+    report.find("{\"size\": 48, \"count\": ") != std::string::npos);
+
+  report.clear();
+  write_stats_report<Alloc::Config>(StatsFormat::Prometheus, sink);
+  printf("%s", report.c_str());
+  SNMALLOC_CHECK(
+    report.find("snmalloc_object_lifetime_ticks_count{size=\"48\"} ") !=
+    std::string::npos);
+  return 0;
+}
+#endif
@@ -0,0 +1,82 @@
+#ifndef SNMALLOC_LOCK_STATS
+#  define SNMALLOC_LOCK_STATS
+#endif
+
+#ifdef SNMALLOC_PASS_THROUGH
+// The allocator's locks are not used when passing through to the system
+// allocator.
+int main()
+{
+  return 0;
+}
+#else
+#  include <chrono>
+#  include <snmalloc/snmalloc.h>
+#  include <string.h>
+#  include <string>
+#  include <test/setup.h>
+#  include <thread>
+
+using namespace snmalloc;
+
+const LockStats* find(const char* name)
+{
+  for (auto* l = LockStats::iterate(); l != nullptr; l = LockStats::iterate(l))
+  {
+    if (strcmp(l->get_name(), name) == 0)
+      return l;
+  }
+  return nullptr;
+}
+
+FlagWord test_lock{"test"};
+
+int main()
+{
+  setup();
+
+  // Acquiring the allocator's locks registers them.
+  auto& a = ThreadAlloc::get();
+  a.dealloc(a.alloc(bits::one_at_bit(24)));
+  SNMALLOC_CHECK(find("alloc_pool") != nullptr);
+  SNMALLOC_CHECK(find("global_range") != nullptr);
+  SNMALLOC_CHECK(find("global_range")->get_acquisitions() != 0);
+
+  SNMALLOC_CHECK(find("test") == nullptr);
+  for (size_t i = 0; i < 10; i++)
+    FlagLock lock(test_lock);
+  auto* stats = find("test");
+  SNMALLOC_CHECK(stats != nullptr);
+  SNMALLOC_CHECK(stats->get_acquisitions() == 10);
+  SNMALLOC_CHECK(stats->get_contended() == 0);
+
+  // Hold the lock while another thread waits for it.
+  std::thread t;
+  {
+    FlagLock lock(test_lock);
+    t = std::thread([]() { FlagLock inner(test_lock); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  }
+  t.join();
+  SNMALLOC_CHECK(stats->get_acquisitions() == 12);
+  SNMALLOC_CHECK(stats->get_contended() == 1);
+  SNMALLOC_CHECK(stats->get_spins() != 0);
+
+  std::string report;
+  auto sink = [&report](const char* data, size_t length) {
+    report.append(data, length);
+  };
+  write_stats_report<Alloc::Config>(StatsFormat::Json, sink);
+  SNMALLOC_CHECK(
+    report.find("{\"name\": \"test\", \"acquisitions\": 12, \"contended\": 1") !=
+    std::string::npos);
+
+  report.clear();
+  write_stats_report<Alloc::Config>(StatsFormat::Prometheus, sink);
+  printf("%s", report.c_str());
+  SNMALLOC_CHECK(
+    report.find("snmalloc_lock_contended_total{lock=\"test\",instance=") !=
+    std::string::npos);
+  return 0;
+}
+#endif
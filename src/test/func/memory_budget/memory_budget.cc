@@ -0,0 +1,111 @@
+#if defined(SNMALLOC_PASS_THROUGH) || !defined(__linux__)
+// This test depends on snmalloc internals and the Linux cgroup interface.
+int main()
+{
+  return 0;
+}
+#else
+#  include <iostream>
+#  include <snmalloc/snmalloc.h>
+#  include <stdio.h>
+#  include <stdlib.h>
+#  include <string>
+#  include <test/setup.h>
+#  include <unistd.h>
+
+using namespace snmalloc;
+
+std::string dir;
+
+void write_file(const char* name, const char* contents)
+{
+  auto path = dir + "/" + name;
+  FILE* f = fopen(path.c_str(), "w");
+  SNMALLOC_CHECK(f != nullptr);
+  fputs(contents, f);
+  fclose(f);
+}
+
+void check_budget(const char* max, const char* high, size_t expected)
+{
+  write_file("memory.max", max);
+  write_file("memory.high", high);
+  MemoryBudget::refresh<DefaultPal>();
+  std::cout << "budget " << MemoryBudget::get_budget() << std::endl;
+  SNMALLOC_CHECK(MemoryBudget::get_budget() == expected);
+}
+
+int main()
+{
+  setup();
+
+  char tmpl[] = "/tmp/snmalloc-cgroup-XXXXXX";
+  SNMALLOC_CHECK(mkdtemp(tmpl) != nullptr);
+  dir = tmpl;
+  DefaultPal::set_cgroup_path(dir.c_str());
+
+  size_t mib = bits::one_at_bit(20);
+
+  // No limit, the default policy is used.
+  check_budget("max\n", "max\n", 0);
+  SNMALLOC_CHECK(MemoryBudget::limit_refill(16 * mib) == 16 * mib);
+  SNMALLOC_CHECK(MemoryBudget::spare_slabs() != 0);
+
+  // A small container scales down refills and keeps no spare slabs.
+  check_budget("268435456\n", "max\n", 256 * mib);
+  SNMALLOC_CHECK(MemoryBudget::limit_refill(16 * mib) == 2 * mib);
+  SNMALLOC_CHECK(MemoryBudget::limit_refill(64 * 1024) == 64 * 1024);
+  SNMALLOC_CHECK(MemoryBudget::spare_slabs() == 0);
+
+  // memory.high takes effect when lower than memory.max.
+  check_budget("268435456\n", "100000000\n", 100000000);
+  SNMALLOC_CHECK(MemoryBudget::limit_refill(16 * mib) == 512 * 1024);
+
+  // A large machine keeps the default policy.
+  check_budget("max\n", "274877906944\n", 256 * 1024 * mib);
+  SNMALLOC_CHECK(MemoryBudget::limit_refill(16 * mib) == 16 * mib);
+  SNMALLOC_CHECK(MemoryBudget::spare_slabs() != 0);
+
+  // The allocator still works under a tight budget.
+  check_budget("16777216\n", "max\n", 16 * mib);
+  auto& a = ThreadAlloc::get();
+  for (size_t size = 16; size < 4 * mib; size <<= 1)
+  {
+    auto p = a.alloc(size);
+    SNMALLOC_CHECK(p != nullptr);
+    a.dealloc(p);
+  }
+
+  // Learning of a budget does not purge, but shrinking a known one does.
+  check_budget("max\n", "max\n", 0);
+  auto epoch = MemoryPressure::get_epoch();
+  check_budget("67108864\n", "max\n", 64 * mib);
+  SNMALLOC_CHECK(MemoryPressure::get_epoch() == epoch);
+  check_budget("33554432\n", "max\n", 32 * mib);
+  SNMALLOC_CHECK(MemoryPressure::get_epoch() != epoch);
+
+  // The tickers only read the limit again once a refresh interval is set.
+  write_file("memory.max", "16777216\n");
+  MemoryBudget::tick<DefaultPal>(DefaultPal::time_in_ms());
+  SNMALLOC_CHECK(MemoryBudget::get_budget() == 32 * mib);
+  MemoryBudget::set_refresh_interval(1);
+  MemoryBudget::tick<DefaultPal>(DefaultPal::time_in_ms() + 2);
+  SNMALLOC_CHECK(MemoryBudget::get_budget() == 16 * mib);
+  MemoryBudget::set_refresh_interval(0);
+
+  // Missing files mean no limit.
+  unlink((dir + "/memory.max").c_str());
+  unlink((dir + "/memory.high").c_str());
+  MemoryBudget::refresh<DefaultPal>();
+  SNMALLOC_CHECK(MemoryBudget::get_budget() == 0);
+  rmdir(dir.c_str());
+
+  // By default the process's own cgroup is found from /proc/self/cgroup.
+  // Its limit depends on the environment, so is only reported.
+  DefaultPal::set_cgroup_path(nullptr);
+  std::cout << "own cgroup limit " << DefaultPal::get_memory_limit()
+            << std::endl;
+
+  return 0;
+}
+#endif
@@ -0,0 +1,85 @@
+#ifndef SNMALLOC_OVERHEAD_STATS
+#  define SNMALLOC_OVERHEAD_STATS
+#endif
+
+#ifdef SNMALLOC_PASS_THROUGH
+// There is no rounding or metadata to account when passing through to the
+// system allocator.
+int main()
+{
+  return 0;
+}
+#else
+#  include <snmalloc/snmalloc.h>
+#  include <string>
+#  include <test/setup.h>
+#  include <vector>
+
+using namespace snmalloc;
+
+int main()
+{
+  setup();
+
+  static constexpr size_t size = 17;
+  static constexpr size_t count = OverheadStats::SAMPLE_INTERVAL * 100;
+  auto sizeclass = size_to_sizeclass(size);
+  auto requested = OverheadStats::get_requested(sizeclass);
+  auto rounded = OverheadStats::get_rounded(sizeclass);
+
+  auto& a = ThreadAlloc::get();
+  std::vector<void*> objects;
+  for (size_t i = 0; i < count; i++)
+    objects.push_back(a.alloc(size));
+
+  // Only allocations of `size` were made, so every sample was one of them.
+  auto samples = (OverheadStats::get_requested(sizeclass) - requested) / size;
+  SNMALLOC_CHECK(samples >= 99);
+  SNMALLOC_CHECK(
+    OverheadStats::get_requested(sizeclass) - requested == samples * size);
+  SNMALLOC_CHECK(
+    OverheadStats::get_rounded(sizeclass) - rounded ==
+    samples * round_size(size));
+  SNMALLOC_CHECK(round_size(size) > size);
+
+  // Large allocations are sampled together.
+  auto large = OverheadStats::get_requested(OverheadStats::LARGE);
+  for (size_t i = 0; i < OverheadStats::SAMPLE_INTERVAL; i++)
+    a.dealloc(a.alloc(MAX_SMALL_SIZECLASS_SIZE + 1));
+  SNMALLOC_CHECK(OverheadStats::get_requested(OverheadStats::LARGE) > large);
+
+  // The slabs for the objects, this allocator, and the pagemap for the
+  // address space that they are in, are all metadata.
+  SNMALLOC_CHECK(OverheadStats::get_slab_metadata() != 0);
+  SNMALLOC_CHECK(
+    OverheadStats::get_allocator_metadata() >=
+    sizeof(CoreAllocator<Alloc::Config>));
+  SNMALLOC_CHECK(OverheadStats::get_pagemap() != 0);
+  SNMALLOC_CHECK(OverheadStats::get_pagemap() % OS_PAGE_SIZE == 0);
+
+  auto slab_metadata = OverheadStats::get_slab_metadata();
+  for (auto* p : objects)
+    a.dealloc(p);
+  a.flush();
+  SNMALLOC_CHECK(OverheadStats::get_slab_metadata() < slab_metadata);
+
+  std::string report;
+  auto sink = [&report](const char* data, size_t length) {
+    report.append(data, length);
+  };
+  write_stats_report<Alloc::Config>(StatsFormat::Json, sink);
+  SNMALLOC_CHECK(report.find("\"pagemap_bytes\": ") != std::string::npos);
+  SNMALLOC_CHECK(
+    report.find("\"overhead_sample_interval\": 64") != std::string::npos);
+  SNMALLOC_CHECK(
+    report.find("\"sampled_rounded_bytes\": ") != std::string::npos);
+
+  report.clear();
+  write_stats_report<Alloc::Config>(StatsFormat::Prometheus, sink);
+  printf("%s", report.c_str());
+  SNMALLOC_CHECK(
+    report.find("snmalloc_sizeclass_sampled_rounded_bytes{size=\"") !=
+    std::string::npos);
+  return 0;
+}
+#endif
@@ -76,6 +76,11 @@ void test_pagemap(bool bounded)
     low = address_cast(heap_base);
     base = heap_base;
     high = low + heap_size;
+
+    // Registering the heap again commits no more of the pagemap.
+    SNMALLOC_CHECK(pagemap_test_bound.register_range(low, high - low) != 0);
+    SNMALLOC_CHECK(pagemap_test_bound.register_range(low, high - low) == 0);
+
     // Store a pattern in heap.
     memset(base, 0x23, high - low);
   }
@@ -85,7 +90,15 @@ void test_pagemap(bool bounded)
       mitigations(random_pagemap) && !aal_supports<StrictProvenance>;
 
     pagemap_test_unbound.init<pagemap_randomize>();
-    pagemap_test_unbound.register_range(low, high - low);
+    SNMALLOC_CHECK(pagemap_test_unbound.register_range(low, high - low) != 0);
+
+    // Each page of the pagemap is counted once, however many registered
+    // ranges share it, and whatever order they are registered in.
+    address_t far = bits::one_at_bit(40);
+    SNMALLOC_CHECK(pagemap_test_unbound.register_range(far, 1) != 0);
+    SNMALLOC_CHECK(pagemap_test_unbound.register_range(low, high - low) == 0);
+    SNMALLOC_CHECK(pagemap_test_unbound.register_range(low, far - low) != 0);
+    SNMALLOC_CHECK(pagemap_test_unbound.register_range(far, 1) == 0);
   }
 
   // Nullptr should still work after init.
@@ -0,0 +1,200 @@
+#if defined(SNMALLOC_PASS_THROUGH) || !defined(__linux__)
+// This test depends on snmalloc internals and Linux file mappings.
+int main()
+{
+  return 0;
+}
+#else
+/**
+ * Persistent heap test
+ * A list is built in a heap in a file, which is then reopened by new
+ * programs, first after the heap was closed and then after a program exited
+ * without closing it.
+ */
+#  include <fcntl.h>
+#  include <iostream>
+#  include <snmalloc/backend/persistentheapconfig.h>
+#  include <snmalloc/snmalloc.h>
+#  include <stdlib.h>
+#  include <string.h>
+#  include <sys/mman.h>
+#  include <sys/wait.h>
+#  include <test/setup.h>
+#  include <unistd.h>
+
+using namespace snmalloc;
+
+using Config = PersistentHeapConfig<PALNoAlloc<DefaultPal>>;
+using PersistentAlloc = LocalAllocator<Config>;
+
+static constexpr size_t REGION_SIZE = bits::one_at_bit(26);
+static constexpr size_t COUNT = 1000;
+
+PersistentAlloc a;
+
+struct Node
+{
+  Node* next;
+  size_t value;
+  char payload[100];
+};
+
+Node* make_node(Node* next, size_t value)
+{
+  auto n = static_cast<Node*>(a.alloc(sizeof(Node)));
+  SNMALLOC_CHECK(n != nullptr);
+  n->next = next;
+  n->value = value;
+  memset(n->payload, static_cast<int>(value & 0xff), sizeof(n->payload));
+  return n;
+}
+
+/**
+ * Check the list holds the values `first` to `last`, in descending order.
+ */
+void check_list(Node* n, size_t first, size_t last)
+{
+  for (size_t value = last; value + 1 > first; value--)
+  {
+    SNMALLOC_CHECK(n != nullptr);
+    SNMALLOC_CHECK(n->value == value);
+    for (size_t i = 0; i < sizeof(n->payload); i++)
+      SNMALLOC_CHECK(
+        static_cast<unsigned char>(n->payload[i]) == (value & 0xff));
+    n = n->next;
+  }
+  SNMALLOC_CHECK(n == nullptr);
+}
+
+size_t count_allocators()
+{
+  size_t count = 0;
+  for (auto alloc = AllocPool<Config>::iterate(); alloc != nullptr;
+       alloc = AllocPool<Config>::iterate(alloc))
+    count++;
+  return count;
+}
+
+/**
+ * Reopen the heap, which holds the values `0` to `COUNT - 1`, or `COUNT`
+ * to `2 * COUNT - 1` if it was not closed.
+ */
+int reopen(void* region)
+{
+  SNMALLOC_CHECK(Config::open(region, REGION_SIZE));
+  auto root = static_cast<Node*>(Config::get_root());
+
+  if (Config::was_clean())
+  {
+    std::cout << "Reopened a closed heap" << std::endl;
+    check_list(root, 0, COUNT - 1);
+
+    // Replace the list, and exit without tearing down or closing.
+    Node* list = nullptr;
+    for (size_t i = COUNT; i < 2 * COUNT; i++)
+      list = make_node(list, i);
+    Config::set_root(list);
+    while (root != nullptr)
+    {
+      auto next = root->next;
+      a.dealloc(root);
+      root = next;
+    }
+    _exit(0);
+  }
+
+  std::cout << "Reopened a heap that was not closed" << std::endl;
+  check_list(root, COUNT, 2 * COUNT - 1);
+
+  // The allocator left in use has been recovered, so is reused.
+  auto allocators = count_allocators();
+  a.dealloc(a.alloc(16));
+  SNMALLOC_CHECK(count_allocators() == allocators);
+
+  while (root != nullptr)
+  {
+    auto next = root->next;
+    a.dealloc(root);
+    root = next;
+  }
+  Config::set_root(nullptr);
+  a.teardown();
+  Config::close();
+  return 0;
+}
+
+/**
+ * Run this program to reopen the heap, and check that it succeeded.
+ */
+void run_reopen(const char* program, const char* path, void* region)
+{
+  char base_arg[32];
+  snprintf(base_arg, sizeof(base_arg), "%zx", address_cast(region));
+  char* args[] = {
+    const_cast<char*>(program),
+    const_cast<char*>(path),
+    base_arg,
+    nullptr};
+
+  pid_t child = fork();
+  SNMALLOC_CHECK(child >= 0);
+  if (child == 0)
+  {
+    execv("/proc/self/exe", args);
+    _exit(1);
+  }
+
+  int status;
+  SNMALLOC_CHECK(waitpid(child, &status, 0) == child);
+  SNMALLOC_CHECK(WIFEXITED(status) && (WEXITSTATUS(status) == 0));
+}
+
+int main(int argc, char** argv)
+{
+  setup();
+
+  if (argc == 3)
+  {
+    int fd = open(argv[1], O_RDWR);
+    SNMALLOC_CHECK(fd >= 0);
+    auto base = reinterpret_cast<void*>(strtoull(argv[2], nullptr, 16));
+    void* region = mmap(
+      base, REGION_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (region != base)
+    {
+      // Something else is at the address in this process.
+      std::cout << "Could not map the heap at " << base << std::endl;
+      return 0;
+    }
+    return reopen(region);
+  }
+
+  char path[] = "/tmp/snmalloc-persistent-heap-XXXXXX";
+  int fd = mkstemp(path);
+  SNMALLOC_CHECK(fd >= 0);
+  SNMALLOC_CHECK(ftruncate(fd, REGION_SIZE) == 0);
+  void* region =
+    mmap(nullptr, REGION_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  SNMALLOC_CHECK(region != MAP_FAILED);
+  std::cout << "Persistent heap at " << region << std::endl;
+
+  Config::create(region, REGION_SIZE);
+  SNMALLOC_CHECK(Config::was_clean());
+
+  Node* list = nullptr;
+  for (size_t i = 0; i < COUNT; i++)
+    list = make_node(list, i);
+  Config::set_root(list);
+  a.teardown();
+  Config::close();
+  SNMALLOC_CHECK(munmap(region, REGION_SIZE) == 0);
+
+  run_reopen(argv[0], path, region);
+  run_reopen(argv[0], path, region);
+
+  close(fd);
+  unlink(path);
+  std::cout << "Passed" << std::endl;
+  return 0;
+}
+#endif
@@ -0,0 +1,111 @@
+#ifdef SNMALLOC_PASS_THROUGH // This test depends on snmalloc internals
+int main()
+{
+  return 0;
+}
+#else
+#  include <iostream>
+#  include <snmalloc/snmalloc.h>
+#  include <test/setup.h>
+#  include <vector>
+
+using namespace snmalloc;
+
+size_t current_usage()
+{
+  return Alloc::Config::Backend::get_current_usage();
+}
+
+void check_reserved(size_t size, size_t count, bool pin)
+{
+  std::cout << "check_reserved " << size << " x " << count
+            << (pin ? " pinned" : "") << std::endl;
+  auto& a = ThreadAlloc::get();
+
+  bool result = a.prewarm(size, count, pin);
+  // Pinning can be refused by the platform, for instance because of
+  // RLIMIT_MEMLOCK, so only treat failure as an error when not pinning.
+  if (!result && !pin)
+  {
+    std::cout << "prewarm failed" << std::endl;
+    abort();
+  }
+
+  auto usage = current_usage();
+
+  std::vector<void*> allocs;
+  allocs.reserve(count);
+  for (size_t i = 0; i < count; i++)
+    allocs.push_back(a.alloc(size));
+
+  // The reserved slabs should satisfy all of the allocations.  The random
+  // extra slab mitigation can deliberately request a new slab, so this cannot
+  // be checked when it is enabled.
+  if constexpr (!mitigations(random_extra_slab))
+  {
+    if (current_usage() != usage)
+    {
+      std::cout << "Allocating after prewarm used the backend: " << usage
+                << " -> " << current_usage() << std::endl;
+      abort();
+    }
+  }
+
+  for (auto p : allocs)
+    a.dealloc(p);
+
+  // Reserved slabs are kept after the objects are freed.
+  allocs.clear();
+  for (size_t i = 0; i < count; i++)
+    allocs.push_back(a.alloc(size));
+  for (auto p : allocs)
+    a.dealloc(p);
+}
+
+size_t hook_calls = 0;
+
+void on_hook(void*, size_t)
+{
+  hook_calls++;
+}
+
+void check_large(size_t size, size_t count)
+{
+  std::cout << "check_large " << size << " x " << count << std::endl;
+  auto& a = ThreadAlloc::get();
+
+  // Prewarming allocates nothing, so large allocations, which are always
+  // reported to the hooks, are not reported.
+  AllocHooks::set({&on_hook, &on_hook, nullptr, 0});
+  hook_calls = 0;
+  if (!a.prewarm(size, count))
+  {
+    std::cout << "prewarm failed" << std::endl;
+    abort();
+  }
+  SNMALLOC_CHECK(hook_calls == 0);
+  AllocHooks::set({nullptr, nullptr, nullptr, 0});
+
+  auto p = a.alloc(size);
+  SNMALLOC_CHECK(p != nullptr);
+  a.dealloc(p);
+}
+
+int main()
+{
+  setup();
+
+  check_reserved(16, 1000, false);
+  check_reserved(48, 10000, false);
+  check_reserved(1024, 100, false);
+  check_reserved(sizeclass_to_size(NUM_SMALL_SIZECLASSES - 1), 10, false);
+  check_reserved(128, 100, true);
+
+  check_large(MAX_SMALL_SIZECLASS_SIZE + 1, 4);
+  check_large(bits::one_at_bit(20), 1);
+
+  // Flushing returns the reserved slabs.
+  snmalloc::debug_check_empty<Alloc::Config>();
+  return 0;
+}
+#endif
@@ -0,0 +1,121 @@
+#include "test/setup.h"
+
+#include <iostream>
+#include <snmalloc/backend/realtimeconfig.h>
+#include <snmalloc/snmalloc.h>
+#include <thread>
+#include <vector>
+
+#ifdef assert
+#  undef assert
+#endif
+#define assert please_use_SNMALLOC_ASSERT
+
+using namespace snmalloc;
+
+using RTConfig = RealTimeConfig<DefaultPal>;
+using RTAlloc = LocalAllocator<RTConfig>;
+
+/**
+ * Allocate objects of `object_size` until the budget is exhausted, check
+ * that the allocation failed with ENOMEM, and then free them.  Returns the
+ * number of objects allocated.
+ */
+size_t exhaust(RTAlloc& a, size_t object_size)
+{
+  void* list = nullptr;
+  size_t count = 0;
+  while (true)
+  {
+    errno = 0;
+    auto p = a.alloc(object_size);
+    if (p == nullptr)
+    {
+      SNMALLOC_CHECK(errno == ENOMEM);
+      break;
+    }
+
+    if (
+      RTConfig::capptr_domesticate(
+        nullptr, capptr::AllocWild<void>::unsafe_from(p)) == nullptr)
+    {
+      std::cout << "Allocated outside of budget: " << p << std::endl;
+      abort();
+    }
+
+    *static_cast<void**>(p) = list;
+    list = p;
+    count++;
+  }
+
+  // Memory is reusable after it is freed.
+  while (list != nullptr)
+  {
+    auto next = *static_cast<void**>(list);
+    a.dealloc(list);
+    list = next;
+  }
+
+  return count;
+}
+
+int main()
+{
+#ifndef SNMALLOC_PASS_THROUGH // Depends on snmalloc specific features
+  setup();
+
+  auto budget = bits::one_at_bit(28);
+  RTConfig::init(budget);
+  SNMALLOC_CHECK(RTConfig::is_initialised());
+
+  RTAlloc a;
+
+  // Zeroed allocations must be satisfied without the platform.
+  for (size_t size : {16, 4096, 65536, 1 << 20})
+  {
+    auto p = static_cast<char*>(a.alloc<YesZero>(size));
+    SNMALLOC_CHECK(p != nullptr);
+    for (size_t i = 0; i < size; i++)
+      SNMALLOC_CHECK(p[i] == 0);
+    memset(p, 0xff, size);
+    a.dealloc(p);
+  }
+
+  // Exhaust the budget, this should fail with ENOMEM.
+  size_t object_size = 1 << 16;
+  size_t count = exhaust(a, object_size);
+
+  std::cout << "Allocated " << count << " objects of " << object_size
+            << " from a budget of " << budget << std::endl;
+  SNMALLOC_CHECK(count * object_size > budget / 2);
+
+  // Leave memory cached by an allocator that is returned to the pool.  One
+  // object is kept live, so that the cached blocks cannot coalesce and be
+  // returned when the thread exits.  The cached memory must be reclaimed
+  // before the allocation fails.
+  void* live = nullptr;
+  std::thread t([object_size, &live]() {
+    RTAlloc b;
+    std::vector<void*> allocs;
+    for (size_t i = 0; i < 16; i++)
+      allocs.push_back(b.alloc(object_size));
+    live = allocs[0];
+    for (size_t i = 1; i < allocs.size(); i++)
+      b.dealloc(allocs[i]);
+    b.teardown();
+  });
+  t.join();
+
+  size_t recount = exhaust(a, object_size);
+  std::cout << "Allocated " << recount << " objects after caching in the pool"
+            << std::endl;
+  SNMALLOC_CHECK(recount + 1 >= count);
+  a.dealloc(live);
+
+  auto p = a.alloc(object_size);
+  SNMALLOC_CHECK(p != nullptr);
+  a.dealloc(p);
+
+  a.teardown();
+#endif
+}
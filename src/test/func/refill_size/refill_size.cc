@@ -0,0 +1,156 @@
+/**
+ * Checks the sizes of the refills that the large buddy ranges request from
+ * their parents: they start small, and grow with the memory requested, up to
+ * the configured maximum.  The global range is used with a parent that does
+ * not provide aligned memory, as the POSIX PALs do not.
+ */
+#include <iostream>
+
+#ifdef SNMALLOC_PASS_THROUGH // This test depends on snmalloc internals
+int main()
+{
+  return 0;
+}
+#else
+#  include <snmalloc/backend/base_constants.h>
+#  include <snmalloc/backend_helpers/backend_helpers.h>
+#  include <snmalloc/snmalloc_core.h>
+#  include <test/setup.h>
+#  include <vector>
+
+using namespace snmalloc;
+
+// This test does not use the allocator, so can use the same pagemap type as
+// the default configuration.
+using Pal = DefaultPal;
+using ConcretePagemap =
+  FlatPagemap<MIN_CHUNK_BITS, DefaultPagemapEntry, Pal, false>;
+using Pagemap = BasicPagemap<Pal, ConcretePagemap, DefaultPagemapEntry, false>;
+
+/**
+ * Records the size of each request to the parent range in `sizes`.
+ */
+template<std::vector<size_t>& sizes>
+struct RecordingRange
+{
+  template<typename ParentRange>
+  class Type : public ContainsParent<ParentRange>
+  {
+    using ContainsParent<ParentRange>::parent;
+
+  public:
+    static constexpr bool Aligned = ParentRange::Aligned;
+
+    static constexpr bool ConcurrencySafe = ParentRange::ConcurrencySafe;
+
+    using ChunkBounds = typename ParentRange::ChunkBounds;
+
+    constexpr Type() = default;
+
+    CapPtr<void, ChunkBounds> alloc_range(size_t size)
+    {
+      sizes.push_back(size);
+      return parent.alloc_range(size);
+    }
+
+    void dealloc_range(CapPtr<void, ChunkBounds> base, size_t size)
+    {
+      parent.dealloc_range(base, size);
+    }
+  };
+};
+
+std::vector<size_t> reservations;
+std::vector<size_t> local_refills;
+
+struct C : BaseLocalStateConstants
+{
+  using BaseLocalStateConstants::GlobalCacheMaxSizeBits;
+  using BaseLocalStateConstants::GlobalCacheSizeBits;
+  using BaseLocalStateConstants::LocalCacheMaxSizeBits;
+  using BaseLocalStateConstants::LocalCacheSizeBits;
+};
+
+using GlobalR = Pipe<
+  PalRange<Pal>,
+  PagemapRegisterRange<Pagemap>,
+  RecordingRange<reservations>,
+  LargeBuddyRange<
+    C::GlobalCacheSizeBits,
+    bits::BITS - 1,
+    Pagemap,
+    MinBaseSizeBits<Pal>(),
+    C::GlobalCacheMaxSizeBits>>;
+
+using LocalR = Pipe<
+  GlobalR,
+  RecordingRange<local_refills>,
+  LargeBuddyRange<
+    C::LocalCacheSizeBits,
+    C::LocalCacheMaxSizeBits,
+    Pagemap,
+    bits::next_pow2_bits_const(Pal::page_size),
+    C::LocalCacheMaxSizeBits>>;
+
+void print(const char* name, std::vector<size_t>& sizes)
+{
+  std::cout << name << ":";
+  for (size_t i = 0; i < sizes.size();)
+  {
+    size_t run = 1;
+    while ((i + run < sizes.size()) && (sizes[i + run] == sizes[i]))
+      run++;
+    std::cout << " " << sizes[i];
+    if (run > 1)
+      std::cout << " x" << run;
+    i += run;
+  }
+  std::cout << std::endl;
+}
+
+/**
+ * Check that the refills never shrink, and that the last is `max`.
+ */
+void check_growth(std::vector<size_t>& sizes, size_t max)
+{
+  for (size_t i = 1; i < sizes.size(); i++)
+    SNMALLOC_CHECK(sizes[i] >= sizes[i - 1]);
+  SNMALLOC_CHECK(sizes.back() == max);
+}
+
+int main()
+{
+  setup();
+  Pagemap::concretePagemap.init<false>();
+
+  LocalR local;
+  size_t chunk = MIN_CHUNK_SIZE;
+
+  // A single chunk needs only a small first reservation.
+  SNMALLOC_CHECK(local.alloc_range(chunk) != nullptr);
+  print("reservations", reservations);
+  SNMALLOC_CHECK(reservations.size() == 1);
+  SNMALLOC_CHECK(reservations[0] < bits::one_at_bit(C::GlobalCacheSizeBits));
+  SNMALLOC_CHECK(local_refills.size() == 1);
+  SNMALLOC_CHECK(local_refills[0] < bits::one_at_bit(C::LocalCacheSizeBits));
+
+  // Requesting memory steadily grows both refills to their maximum.
+  size_t total = chunk;
+  while (total < bits::one_at_bit(C::GlobalCacheMaxSizeBits + 3))
+  {
+    SNMALLOC_CHECK(local.alloc_range(chunk) != nullptr);
+    total += chunk;
+    if (
+      (local_refills.back() == bits::one_at_bit(C::LocalCacheMaxSizeBits)) &&
+      (reservations.back() == bits::one_at_bit(C::GlobalCacheMaxSizeBits)))
+      break;
+  }
+  print("reservations", reservations);
+  print("local refills", local_refills);
+  std::cout << "Requested " << total << std::endl;
+  check_growth(local_refills, bits::one_at_bit(C::LocalCacheMaxSizeBits));
+  check_growth(reservations, bits::one_at_bit(C::GlobalCacheMaxSizeBits));
+
+  return 0;
+}
+#endif
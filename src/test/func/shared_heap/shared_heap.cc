@@ -0,0 +1,213 @@
+#if defined(SNMALLOC_PASS_THROUGH) || !defined(__linux__)
+// This test depends on snmalloc internals and Linux shared memory.
+int main()
+{
+  return 0;
+}
+#else
+/**
+ * Shared heap test
+ * A producer process passes objects in a shared heap to a consumer process,
+ * which frees them and passes back its own.  The consumer is first forked,
+ * and then run as a new program that attaches to the heap.
+ */
+#  include <iostream>
+#  include <snmalloc/backend/sharedheapconfig.h>
+#  include <snmalloc/snmalloc.h>
+#  include <stdlib.h>
+#  include <string.h>
+#  include <sys/mman.h>
+#  include <sys/wait.h>
+#  include <test/setup.h>
+#  include <unistd.h>
+#  include <vector>
+
+using namespace snmalloc;
+
+using Config = SharedHeapConfig<PALNoAlloc<DefaultPal>>;
+using SharedAlloc = LocalAllocator<Config>;
+
+// The lock in the region holds nothing that is private to a process.
+static_assert(sizeof(SharedFlagWord) == sizeof(std::atomic_bool));
+
+static constexpr size_t REGION_SIZE = bits::one_at_bit(26);
+static constexpr size_t COUNT = 1000;
+static constexpr size_t SIZE = 100;
+
+SharedAlloc a;
+
+void fill(void* p, size_t seed)
+{
+  memset(p, static_cast<int>(seed & 0xff), SIZE);
+}
+
+void check(void* p, size_t seed)
+{
+  auto bytes = static_cast<unsigned char*>(p);
+  for (size_t i = 0; i < SIZE; i++)
+    SNMALLOC_CHECK(bytes[i] == (seed & 0xff));
+}
+
+void send(int fd, void* p)
+{
+  SNMALLOC_CHECK(write(fd, &p, sizeof(p)) == sizeof(p));
+}
+
+void* receive(int fd)
+{
+  void* p;
+  SNMALLOC_CHECK(read(fd, &p, sizeof(p)) == sizeof(p));
+  return p;
+}
+
+/**
+ * Free the producer's objects, which it will then see as free, and send it
+ * some of our own.
+ */
+void consumer(int in, int out)
+{
+  // Tell the producer that the heap is ready.
+  send(out, &a);
+  for (size_t i = 0; i < COUNT; i++)
+  {
+    void* p = receive(in);
+    check(p, i);
+    a.dealloc(p);
+  }
+  // The last object sent is held in the producer's message queue until
+  // another arrives, so send one more that it does not check.
+  a.flush();
+  a.dealloc(receive(in));
+  a.flush();
+
+  for (size_t i = 0; i < COUNT; i++)
+  {
+    void* p = a.alloc(SIZE);
+    SNMALLOC_CHECK(p != nullptr);
+    fill(p, ~i);
+    send(out, p);
+  }
+}
+
+void producer(int out, int in, pid_t child)
+{
+  int status;
+  if (receive(in) == nullptr)
+  {
+    // The consumer could not use the heap.
+    SNMALLOC_CHECK(waitpid(child, &status, 0) == child);
+    return;
+  }
+
+  std::vector<void*> objects;
+  for (size_t i = 0; i <= COUNT; i++)
+  {
+    void* p = a.alloc(SIZE);
+    SNMALLOC_CHECK(p != nullptr);
+    fill(p, i);
+    objects.push_back(p);
+    send(out, p);
+  }
+
+  // The consumer's objects are intact, and distinct from ours.
+  for (size_t i = 0; i < COUNT; i++)
+  {
+    void* p = receive(in);
+    check(p, ~i);
+    for (auto q : objects)
+      SNMALLOC_CHECK(p != q);
+  }
+
+  SNMALLOC_CHECK(waitpid(child, &status, 0) == child);
+  SNMALLOC_CHECK(WIFEXITED(status) && (WEXITSTATUS(status) == 0));
+
+  // The consumer's frees have been sent back to this process, which has
+  // either returned the slab or marked the object as free.
+  uint64_t bitmap[SharedAlloc::ALLOCATED_BITMAP_WORDS];
+  auto sc = size_to_sizeclass(SIZE);
+  for (size_t i = 0; i < COUNT; i++)
+  {
+    auto p = objects[i];
+    if (a.allocated_objects(p, bitmap) == 0)
+      continue;
+    size_t index = (address_cast(p) % sizeclass_to_slab_size(sc)) /
+      sizeclass_to_size(sc);
+    SNMALLOC_CHECK(((bitmap[index / 64] >> (index % 64)) & 1) == 0);
+  }
+}
+
+int main(int argc, char** argv)
+{
+  setup();
+
+  if (argc == 5)
+  {
+    // Run as a new program, to attach to the heap.
+    int fd = atoi(argv[1]);
+    int in = atoi(argv[3]);
+    int out = atoi(argv[4]);
+    auto base = reinterpret_cast<void*>(strtoull(argv[2], nullptr, 16));
+    void* region = mmap(
+      base, REGION_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (region != base)
+    {
+      // Something else is at the address in this process.
+      std::cout << "Could not map the region at " << base << std::endl;
+      send(out, nullptr);
+      return 0;
+    }
+    SNMALLOC_CHECK(Config::attach(region, REGION_SIZE));
+    consumer(in, out);
+    return 0;
+  }
+
+  int fd = memfd_create("snmalloc-shared-heap", 0);
+  SNMALLOC_CHECK(fd >= 0);
+  SNMALLOC_CHECK(ftruncate(fd, REGION_SIZE) == 0);
+  void* region =
+    mmap(nullptr, REGION_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  SNMALLOC_CHECK(region != MAP_FAILED);
+  std::cout << "Shared heap at " << region << std::endl;
+
+  Config::create(region, REGION_SIZE);
+  SNMALLOC_CHECK(!Config::attach(region, Config::Pal::page_size));
+
+  int to_consumer[2];
+  int to_producer[2];
+  SNMALLOC_CHECK(pipe(to_consumer) == 0);
+  SNMALLOC_CHECK(pipe(to_producer) == 0);
+
+  // A child forked before anything is allocated shares the heap.
+  pid_t child = fork();
+  SNMALLOC_CHECK(child >= 0);
+  if (child == 0)
+  {
+    consumer(to_consumer[0], to_producer[1]);
+    _exit(0);
+  }
+  producer(to_consumer[1], to_producer[0], child);
+
+  // A new program maps the region at the same address and attaches to it.
+  char fd_arg[32];
+  char base_arg[32];
+  char in_arg[32];
+  char out_arg[32];
+  snprintf(fd_arg, sizeof(fd_arg), "%d", fd);
+  snprintf(base_arg, sizeof(base_arg), "%zx", address_cast(region));
+  snprintf(in_arg, sizeof(in_arg), "%d", to_consumer[0]);
+  snprintf(out_arg, sizeof(out_arg), "%d", to_producer[1]);
+  char* args[] = {argv[0], fd_arg, base_arg, in_arg, out_arg, nullptr};
+
+  child = fork();
+  SNMALLOC_CHECK(child >= 0);
+  if (child == 0)
+  {
+    execv("/proc/self/exe", args);
+    _exit(1);
+  }
+  producer(to_consumer[1], to_producer[0], child);
+
+  std::cout << "Passed" << std::endl;
+  return 0;
+}
+#endif
@@ -0,0 +1,94 @@
+#if defined(SNMALLOC_PASS_THROUGH) || !defined(__linux__)
+// The statistics depend on snmalloc internals, and the segment on Linux.
+int main()
+{
+  return 0;
+}
+#else
+#  include <snmalloc/snmalloc.h>
+#  include <test/setup.h>
+#  include <vector>
+
+using namespace snmalloc;
+
+/**
+ * Map the segment as a viewer in another process would.
+ */
+const SharedStatsSegment* attach()
+{
+  char path[64];
+  shared_stats_path(path, static_cast<uint64_t>(getpid()));
+  int fd = open(path, O_RDONLY);
+  SNMALLOC_CHECK(fd >= 0);
+  void* p =
+    mmap(nullptr, sizeof(SharedStatsSegment), PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  SNMALLOC_CHECK(p != MAP_FAILED);
+  return static_cast<const SharedStatsSegment*>(p);
+}
+
+int main()
+{
+  setup();
+
+  // A file left by an earlier process with this pid is replaced, not reused.
+  char stale_path[64];
+  shared_stats_path(stale_path, static_cast<uint64_t>(getpid()));
+  int stale = open(stale_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  SNMALLOC_CHECK(stale >= 0);
+  SNMALLOC_CHECK(write(stale, "stale", 5) == 5);
+  close(stale);
+
+  using Stats = SharedStats<Alloc::Config>;
+  SNMALLOC_CHECK(Stats::enable(0));
+  auto* segment = attach();
+  SNMALLOC_CHECK(segment->is_compatible());
+
+  StatsSnapshot stats;
+  uint64_t time_ms;
+  SNMALLOC_CHECK(segment->read(stats, time_ms));
+  auto before = segment->sequence.load();
+
+  auto& a = ThreadAlloc::get();
+  std::vector<void*> objects;
+  for (size_t i = 0; i < 1000; i++)
+    objects.push_back(a.alloc(48));
+  auto* large = a.alloc(bits::one_at_bit(20));
+
+  // Publish directly, as the ticker may not yet have run.
+  Stats::publish();
+  SNMALLOC_CHECK(segment->read(stats, time_ms));
+  SNMALLOC_CHECK(segment->sequence.load() > before);
+  SNMALLOC_CHECK(stats.allocators >= 1);
+  SNMALLOC_CHECK(stats.current_memory_bytes != 0);
+  SNMALLOC_CHECK(stats.large_bytes == bits::one_at_bit(20));
+  auto sizeclass = size_to_sizeclass(48);
+  SNMALLOC_CHECK(segment->sizeclass_sizes[sizeclass] == 48);
+  SNMALLOC_CHECK(stats.slabs[sizeclass] != 0);
+
+  // With a zero interval, the statistics are published whenever the slow
+  // paths read the clock.
+  before = segment->sequence.load();
+  auto start = DefaultPal::time_in_ms();
+  while ((segment->sequence.load() == before) &&
+         (DefaultPal::time_in_ms() - start < 10000))
+  {
+    std::vector<void*> batch;
+    for (size_t i = 0; i < 10000; i++)
+      batch.push_back(a.alloc(256));
+    for (auto p : batch)
+      a.dealloc(p);
+  }
+  SNMALLOC_CHECK(segment->sequence.load() != before);
+
+  for (auto p : objects)
+    a.dealloc(p);
+  a.dealloc(large);
+
+  Stats::disable();
+  char path[64];
+  shared_stats_path(path, static_cast<uint64_t>(getpid()));
+  SNMALLOC_CHECK(access(path, F_OK) != 0);
+  return 0;
+}
+#endif
@@ -0,0 +1,106 @@
+#if defined(SNMALLOC_PASS_THROUGH) || !(defined(__unix__) || defined(__APPLE__))
+// The report depends on snmalloc internals, and the export on POSIX.
+int main()
+{
+  return 0;
+}
+#else
+#  include <snmalloc/snmalloc.h>
+#  include <stdio.h>
+#  include <string>
+#  include <test/setup.h>
+#  include <vector>
+
+#  include "../../../snmalloc/override/stats_export.cc"
+
+using namespace snmalloc;
+
+std::string report(StatsFormat format)
+{
+  std::string result;
+  auto sink = [&result](const char* data, size_t length) {
+    result.append(data, length);
+  };
+  write_stats_report<Alloc::Config>(format, sink);
+  return result;
+}
+
+bool contains(const std::string& s, const char* needle)
+{
+  return s.find(needle) != std::string::npos;
+}
+
+std::string read_file(const char* path)
+{
+  std::string result;
+  FILE* f = fopen(path, "r");
+  SNMALLOC_CHECK(f != nullptr);
+  char buffer[256];
+  size_t n;
+  while ((n = fread(buffer, 1, sizeof(buffer), f)) != 0)
+    result.append(buffer, n);
+  fclose(f);
+  return result;
+}
+
+void test_report()
+{
+  auto json = report(StatsFormat::Json);
+  printf("%s", json.c_str());
+  SNMALLOC_CHECK(json.front() == '{');
+  SNMALLOC_CHECK(contains(json, "\"current_memory_bytes\": "));
+  SNMALLOC_CHECK(contains(json, "\"peak_memory_bytes\": "));
+  SNMALLOC_CHECK(contains(json, "{\"size\": 48, \"slabs\": "));
+  SNMALLOC_CHECK(contains(json, "\"small_alloc_slow\": "));
+  SNMALLOC_CHECK(contains(json, "\n}\n"));
+
+  auto prometheus = report(StatsFormat::Prometheus);
+  printf("%s", prometheus.c_str());
+  SNMALLOC_CHECK(contains(prometheus, "snmalloc_current_memory_bytes "));
+  SNMALLOC_CHECK(contains(prometheus, "snmalloc_large_bytes 1048576\n"));
+  SNMALLOC_CHECK(
+    contains(prometheus, "snmalloc_sizeclass_slab_bytes{size=\"48\"} "));
+  SNMALLOC_CHECK(
+    contains(prometheus, "snmalloc_events_total{event=\"pal_commit\"} "));
+}
+
+void test_export()
+{
+  char path[] = "/tmp/snmalloc-stats-XXXXXX";
+  int fd = mkstemp(path);
+  SNMALLOC_CHECK(fd >= 0);
+  close(fd);
+
+  setenv("SNMALLOC_STATS_FILE", path, 1);
+  setenv("SNMALLOC_STATS_FORMAT", "prometheus", 1);
+  setenv("SNMALLOC_STATS_SIGNAL", "USR1", 1);
+  init_stats_export();
+
+  raise(SIGUSR1);
+  auto contents = read_file(path);
+  SNMALLOC_CHECK(contains(contents, "snmalloc_peak_memory_bytes "));
+  SNMALLOC_CHECK(contains(contents, "snmalloc_large_bytes 1048576\n"));
+
+  // Stop the exit handler from recreating the file.
+  unlink(path);
+  stats_path[0] = '\0';
+}
+
+int main()
+{
+  setup();
+
+  auto& a = ThreadAlloc::get();
+  std::vector<void*> objects;
+  for (size_t i = 0; i < 100; i++)
+    objects.push_back(a.alloc(48));
+  objects.push_back(a.alloc(bits::one_at_bit(20)));
+
+  test_report();
+  test_export();
+
+  for (auto p : objects)
+    a.dealloc(p);
+  return 0;
+}
+#endif
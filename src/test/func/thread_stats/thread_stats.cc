@@ -0,0 +1,155 @@
+/**
+ * Per-thread statistics test
+ * Check the counters through the C++, C and mallctl interfaces.
+ */
+#define SNMALLOC_THREAD_STATS
+
+#include <test/setup.h>
+#include <thread>
+
+#define SNMALLOC_NAME_MANGLE(a) our_##a
+#include "../../../snmalloc/override/jemalloc_compat.cc"
+#include "../../../snmalloc/override/malloc-extensions.cc"
+#include "../../../snmalloc/override/malloc.cc"
+
+using namespace snmalloc;
+
+uint64_t read_mallctl(const char* name)
+{
+  uint64_t value = 0;
+  size_t len = sizeof(value);
+  SNMALLOC_CHECK(our_mallctl(name, &value, &len, nullptr, 0) == 0);
+  SNMALLOC_CHECK(len == sizeof(value));
+  return value;
+}
+
+void test_counts()
+{
+  auto& stats = ThreadAlloc::get().get_thread_stats();
+  auto allocated = stats.allocated;
+  auto deallocated = stats.deallocated;
+
+  // Small, medium and large objects are counted at their usable size.
+  for (size_t size = 1; size < bits::one_at_bit(24); size = size * 3 + 1)
+  {
+    void* p = our_malloc(size);
+    SNMALLOC_CHECK(p != nullptr);
+    SNMALLOC_CHECK(stats.allocated - allocated == our_malloc_usable_size(p));
+    our_free(p);
+    SNMALLOC_CHECK(
+      stats.deallocated - deallocated == stats.allocated - allocated);
+    allocated = stats.allocated;
+    deallocated = stats.deallocated;
+  }
+
+  // Zero sized allocations and frees of nullptr.
+  our_free(our_malloc(0));
+  our_free(nullptr);
+  SNMALLOC_CHECK(stats.allocated - allocated == round_size(0));
+  SNMALLOC_CHECK(stats.deallocated - deallocated == round_size(0));
+}
+
+void test_remote()
+{
+  // Objects freed by another thread count against that thread.
+  auto& stats = ThreadAlloc::get().get_thread_stats();
+  auto deallocated = stats.deallocated;
+  void* p = our_malloc(48);
+  size_t size = our_malloc_usable_size(p);
+
+  uint64_t remote_deallocated = 0;
+  std::thread t([&]() {
+    auto& remote_stats = ThreadAlloc::get().get_thread_stats();
+    auto before = remote_stats.deallocated;
+    our_free(p);
+    remote_deallocated = remote_stats.deallocated - before;
+  });
+  t.join();
+
+  SNMALLOC_CHECK(remote_deallocated == size);
+  SNMALLOC_CHECK(stats.deallocated == deallocated);
+}
+
+void test_prewarm()
+{
+  // Memory reserved by the allocator for later use is not counted.
+  auto& a = ThreadAlloc::get();
+  auto& stats = a.get_thread_stats();
+  auto allocated = stats.allocated;
+  auto deallocated = stats.deallocated;
+  SNMALLOC_CHECK(a.prewarm(48, 100));
+  SNMALLOC_CHECK(a.prewarm(bits::one_at_bit(20), 4));
+  SNMALLOC_CHECK(stats.allocated == allocated);
+  SNMALLOC_CHECK(stats.deallocated == deallocated);
+}
+
+void test_c_api()
+{
+  thread_alloc_stats_v1 before;
+  SNMALLOC_CHECK(get_thread_alloc_stats_v1(&before) == 0);
+  void* p = our_malloc(100);
+  size_t size = our_malloc_usable_size(p);
+  our_free(p);
+  thread_alloc_stats_v1 after;
+  SNMALLOC_CHECK(get_thread_alloc_stats_v1(&after) == 0);
+  SNMALLOC_CHECK(after.allocated - before.allocated == size);
+  SNMALLOC_CHECK(after.deallocated - before.deallocated == size);
+}
+
+void test_mallctl()
+{
+  auto allocated = read_mallctl("thread.allocated");
+  auto deallocated = read_mallctl("thread.deallocated");
+  void* p = our_malloc(1000);
+  size_t size = our_malloc_usable_size(p);
+  SNMALLOC_CHECK(read_mallctl("thread.allocated") - allocated == size);
+  our_free(p);
+  SNMALLOC_CHECK(read_mallctl("thread.deallocated") - deallocated == size);
+
+  // The pointer forms refer to the live counters.
+  const uint64_t* allocatedp = nullptr;
+  size_t len = sizeof(allocatedp);
+  SNMALLOC_CHECK(
+    our_mallctl("thread.allocatedp", &allocatedp, &len, nullptr, 0) == 0);
+  allocated = *allocatedp;
+  p = our_malloc(1000);
+  SNMALLOC_CHECK(*allocatedp - allocated == size);
+  our_free(p);
+
+  // Lookup by MIB.
+  size_t mib[2];
+  size_t miblen = 2;
+  SNMALLOC_CHECK(our_mallctlnametomib("thread.deallocated", mib, &miblen) == 0);
+  SNMALLOC_CHECK(miblen == 2);
+  uint64_t value = 0;
+  len = sizeof(value);
+  SNMALLOC_CHECK(our_mallctlbymib(mib, miblen, &value, &len, nullptr, 0) == 0);
+  SNMALLOC_CHECK(value == read_mallctl("thread.deallocated"));
+
+  // Errors.
+  SNMALLOC_CHECK(
+    our_mallctl("thread.arena", &value, &len, nullptr, 0) == ENOENT);
+  SNMALLOC_CHECK(
+    our_mallctl("thread.allocated", nullptr, nullptr, &value, len) == EPERM);
+  uint32_t small = 0;
+  len = sizeof(small);
+  SNMALLOC_CHECK(
+    our_mallctl("thread.allocated", &small, &len, nullptr, 0) == EINVAL);
+}
+
+int main()
+{
+  setup();
+#ifdef SNMALLOC_PASS_THROUGH
+  // Statistics are not maintained when passing through to the system
+  // allocator.
+  return 0;
+#else
+  test_counts();
+  test_remote();
+  test_prewarm();
+  test_c_api();
+  test_mallctl();
+  return 0;
+#endif
+}
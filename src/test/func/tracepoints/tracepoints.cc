@@ -0,0 +1,55 @@
+#if !defined(SNMALLOC_USDT) || !__has_include(<sys/sdt.h>) || \
+  !defined(__linux__) || defined(SNMALLOC_PASS_THROUGH)
+// No probes are added to this build.
+int main()
+{
+  return 0;
+}
+#else
+#  include <snmalloc/snmalloc.h>
+#  include <stdio.h>
+#  include <string>
+#  include <test/setup.h>
+
+/**
+ * Check that the probes are described in this binary's notes, where
+ * tracers look for them.  The names of the provider and probe are stored as
+ * adjacent strings in each note.
+ */
+int main()
+{
+  setup();
+
+  std::string binary;
+  FILE* f = fopen("/proc/self/exe", "rb");
+  SNMALLOC_CHECK(f != nullptr);
+  char buffer[4096];
+  size_t n;
+  while ((n = fread(buffer, 1, sizeof(buffer), f)) != 0)
+    binary.append(buffer, n);
+  fclose(f);
+
+  SNMALLOC_CHECK(binary.find(".note.stapsdt") != std::string::npos);
+  for (auto probe :
+       {"slab_acquire",
+        "slab_release",
+        "message_queue_drain",
+        "remote_post",
+        "buddy_refill",
+        "pal_commit",
+        "pal_decommit"})
+  {
+    auto name = std::string("snmalloc") + '\0' + probe + '\0';
+    if (binary.find(name) == std::string::npos)
+    {
+      printf("Missing probe %s\n", probe);
+      return 1;
+    }
+  }
+
+  // Exercise the allocator so that the probed code is linked.
+  auto& a = snmalloc::ThreadAlloc::get();
+  a.dealloc(a.alloc(16));
+  return 0;
+}
+#endif
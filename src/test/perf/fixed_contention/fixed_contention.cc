@@ -0,0 +1,99 @@
+#if defined(SNMALLOC_PASS_THROUGH) || !(defined(__unix__) || defined(__APPLE__))
+// This test depends on snmalloc internals and fork.
+int main()
+{
+  return 0;
+}
+#else
+/**
+ * Measures the contention on the global range of a fixed region, with the
+ * range in one shard and in several.  Each configuration is run in a new
+ * process, as they share the pagemap.
+ *
+ * The region is small enough that thread local caching of chunks is
+ * disabled, so every allocation of a large object takes the global lock.
+ */
+#  include "test/opt.h"
+#  include "test/setup.h"
+
+#  include <chrono>
+#  include <iostream>
+#  include <snmalloc/backend/fixedglobalconfig.h>
+#  include <snmalloc/snmalloc.h>
+#  include <sys/wait.h>
+#  include <thread>
+#  include <unistd.h>
+#  include <vector>
+
+using namespace snmalloc;
+
+static constexpr size_t REGION_SIZE = bits::one_at_bit(26);
+static constexpr size_t OBJECT_SIZE = bits::one_at_bit(16);
+
+template<size_t Shards>
+using Config = FixedRangeConfig<PALNoAlloc<DefaultPal>, void, Shards>;
+
+template<size_t Shards>
+void churn(size_t count)
+{
+  LocalAllocator<Config<Shards>> a;
+  void* objects[4];
+  for (size_t i = 0; i < count; i++)
+  {
+    for (auto& p : objects)
+    {
+      p = a.alloc(OBJECT_SIZE);
+      SNMALLOC_CHECK(p != nullptr);
+    }
+    for (auto p : objects)
+      a.dealloc(p);
+  }
+  a.teardown();
+}
+
+template<size_t Shards>
+void run(size_t cores, size_t count)
+{
+  pid_t child = fork();
+  SNMALLOC_CHECK(child >= 0);
+  if (child != 0)
+  {
+    int status;
+    SNMALLOC_CHECK(waitpid(child, &status, 0) == child);
+    SNMALLOC_CHECK(WIFEXITED(status) && (WEXITSTATUS(status) == 0));
+    return;
+  }
+
+  auto base = DefaultPal::reserve(REGION_SIZE);
+  DefaultPal::notify_using<NoZero>(base, REGION_SIZE);
+  Config<Shards>::init(nullptr, base, REGION_SIZE);
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < cores; i++)
+    threads.emplace_back(churn<Shards>, count);
+  for (auto& t : threads)
+    t.join();
+  auto end = std::chrono::steady_clock::now();
+
+  std::cout << Shards << " shard(s), " << cores << " threads: "
+            << std::chrono::duration_cast<std::chrono::milliseconds>(
+                 end - start)
+                 .count()
+            << "ms" << std::endl;
+  _exit(0);
+}
+
+int main(int argc, char** argv)
+{
+  setup();
+
+  opt::Opt opt(argc, argv);
+  size_t cores = opt.is<size_t>("--cores", 4);
+  size_t count = opt.is<size_t>("--count", 1 << 12);
+
+  run<1>(cores, count);
+  run<8>(cores, count);
+  return 0;
+}
+#endif
@@ -1,3 +1,15 @@
+#ifdef SNMALLOC_USE_SINGLE_THREAD_CONFIG
+// Built as perf-singlethread-singlethreadconfig, so that the cost of the
+// cross-thread machinery can be seen by comparing its timings with those from
+// perf-singlethread-fast.
+#  include <snmalloc/backend/singlethreadconfig.h>
+#  include <snmalloc/snmalloc_core.h>
+#  define SNMALLOC_PROVIDE_OWN_CONFIG
+namespace snmalloc
+{
+  using Alloc = LocalAllocator<SingleThreadConfig>;
+}
+#endif
 #include <snmalloc/snmalloc.h>
 #include <test/measuretime.h>
 #include <test/setup.h>
@@ -60,13 +72,44 @@ void test_alloc_dealloc(size_t count, size_t size, bool write)
     }
   }
 
-  snmalloc::debug_check_empty<StandardConfig>();
+  snmalloc::debug_check_empty<Alloc::Config>();
+}
+
+/**
+ * Measure the cost of the per-thread statistics on the fast paths.  Compare
+ * the timings from perf-singlethread-fast with those from
+ * perf-singlethread-threadstats, which is built with SNMALLOC_THREAD_STATS.
+ */
+void test_thread_stats(size_t count, size_t size)
+{
+  auto& alloc = ThreadAlloc::get();
+  auto before = alloc.get_thread_stats();
+
+  {
+    MeasureTime m;
+    m << "Thread stats: " << ThreadStatsEnabled << ", Count: " << std::setw(8)
+      << count << ", Size: " << std::setw(6) << size;
+
+    for (size_t i = 0; i < count; i++)
+    {
+      void* p = alloc.alloc(size);
+      alloc.dealloc(p);
+    }
+  }
+
+  auto& after = alloc.get_thread_stats();
+  uint64_t expected = ThreadStatsEnabled ? count * round_size(size) : 0;
+  SNMALLOC_CHECK(after.allocated - before.allocated == expected);
+  SNMALLOC_CHECK(after.deallocated - before.deallocated == expected);
 }
 
 int main(int, char**)
 {
   setup();
 
+  for (size_t size = 16; size <= 1 << 12; size <<= 2)
+    test_thread_stats(1 << 20, size);
+
   for (size_t size = 16; size <= 128; size <<= 1)
   {
     test_alloc_dealloc<NoZero>(1 << 15, size, false);
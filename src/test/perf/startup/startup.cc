@@ -68,9 +68,10 @@ public:
   }
 };
 
-int main()
+void run(size_t cores)
 {
-  counters.resize(std::thread::hardware_concurrency());
+  counters.clear();
+  counters.resize(cores);
 
   ParallelTest test(
     [](size_t id) {
@@ -91,4 +92,19 @@ int main()
               << std::endl;
     start = counter;
   }
-}
\ No newline at end of file
+}
+
+int main()
+{
+  size_t cores = std::thread::hardware_concurrency();
+
+  std::cout << "Cold start" << std::endl;
+  run(cores);
+
+  // The allocators of the first run are back in the pool, reserve enough for
+  // twice as many threads so that each thread of the second run finds an
+  // allocator waiting for it.
+  std::cout << "Reserved allocators" << std::endl;
+  snmalloc::reserve_allocators<snmalloc::Alloc::Config>(2 * cores);
+  run(2 * cores);
+}
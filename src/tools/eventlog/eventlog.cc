@@ -0,0 +1,127 @@
+/**
+ * eventlog: decodes a log written by `EventLog::write`, merging the records
+ * of every thread into a single timeline ordered by timestamp.
+ *
+ *   eventlog <file>
+ *
+ * Each line gives the ticks since the first record, the ring (one per
+ * thread) that recorded it, the event, and its payload.  A count of each
+ * event follows the timeline.
+ */
+#include <algorithm>
+#include <snmalloc/snmalloc.h>
+#include <stdio.h>
+#include <vector>
+
+using namespace snmalloc;
+
+namespace
+{
+  struct Entry
+  {
+    uint64_t ring;
+    LogRecord record;
+  };
+
+  bool read_exact(FILE* f, void* data, size_t length)
+  {
+    return fread(data, 1, length, f) == length;
+  }
+} // namespace
+
+int main(int argc, char** argv)
+{
+  if (argc != 2)
+  {
+    fprintf(stderr, "usage: %s <file>\n", argv[0]);
+    return 1;
+  }
+
+  FILE* f = fopen(argv[1], "rb");
+  if (f == nullptr)
+  {
+    perror(argv[1]);
+    return 1;
+  }
+
+  EventLog::Header h;
+  if (
+    !read_exact(f, &h, sizeof(h)) || (h.magic != EventLog::MAGIC) ||
+    (h.version != EventLog::VERSION) || (h.record_size != sizeof(LogRecord)))
+  {
+    fprintf(stderr, "%s: %s is not an event log\n", argv[0], argv[1]);
+    return 1;
+  }
+
+  std::vector<Entry> entries;
+  for (uint64_t i = 0; i < h.rings; i++)
+  {
+    EventLog::RingHeader rh;
+    if (!read_exact(f, &rh, sizeof(rh)))
+    {
+      fprintf(stderr, "%s: %s is truncated\n", argv[0], argv[1]);
+      return 1;
+    }
+    if (rh.written > rh.count)
+    {
+      printf(
+        "# ring %llu lost its oldest %llu records\n",
+        static_cast<unsigned long long>(rh.index),
+        static_cast<unsigned long long>(rh.written - rh.count));
+    }
+    for (uint64_t j = 0; j < rh.count; j++)
+    {
+      Entry e{rh.index, {}};
+      if (!read_exact(f, &e.record, sizeof(LogRecord)))
+      {
+        fprintf(stderr, "%s: %s is truncated\n", argv[0], argv[1]);
+        return 1;
+      }
+      entries.push_back(e);
+    }
+  }
+  fclose(f);
+
+  if (h.dropped != 0)
+  {
+    printf(
+      "# %llu events were dropped as all rings were in use\n",
+      static_cast<unsigned long long>(h.dropped));
+  }
+
+  std::stable_sort(
+    entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+      return a.record.tick < b.record.tick;
+    });
+
+  uint64_t counts[NUM_LOG_EVENTS] = {};
+  uint64_t start = entries.empty() ? 0 : entries.front().record.tick;
+  printf("%-14s %-5s %-18s %-18s %s\n", "tick", "ring", "event", "a", "b");
+  for (auto& e : entries)
+  {
+    auto event = static_cast<size_t>(e.record.event);
+    const char* name = "unknown";
+    if (event < NUM_LOG_EVENTS)
+    {
+      name = log_event_names[event];
+      counts[event]++;
+    }
+    printf(
+      "%-14llu %-5llu %-18s 0x%-16llx 0x%llx\n",
+      static_cast<unsigned long long>(e.record.tick - start),
+      static_cast<unsigned long long>(e.ring),
+      name,
+      static_cast<unsigned long long>(e.record.payload[0]),
+      static_cast<unsigned long long>(e.record.payload[1]));
+  }
+
+  printf("\n");
+  for (size_t i = 0; i < NUM_LOG_EVENTS; i++)
+  {
+    printf(
+      "# %-18s %llu\n",
+      log_event_names[i],
+      static_cast<unsigned long long>(counts[i]));
+  }
+  return 0;
+}
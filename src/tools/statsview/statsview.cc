@@ -0,0 +1,143 @@
+/**
+ * statsview: shows the allocator statistics that a process publishes into
+ * shared memory (see `SharedStats`), with the rate at which each changes.
+ *
+ *   statsview <pid> [interval_ms] [iterations]
+ *
+ * The process must have enabled publication, for instance by running with
+ * the shim and `SNMALLOC_SHARED_STATS=<interval_ms>`.  With no iteration
+ * count, the statistics are shown until the viewer is interrupted or the
+ * process exits.
+ */
+#include <snmalloc/snmalloc.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace snmalloc;
+
+namespace
+{
+  double rate(uint64_t now, uint64_t before, double seconds)
+  {
+    return (static_cast<double>(now) - static_cast<double>(before)) / seconds;
+  }
+
+  void show(
+    const SharedStatsSegment& segment,
+    const StatsSnapshot& now,
+    const StatsSnapshot& before,
+    double seconds,
+    uint64_t age_ms)
+  {
+    printf("\nupdated %llu ms ago\n", static_cast<unsigned long long>(age_ms));
+    printf("%-34s %16s %14s\n", "", "value", "per second");
+
+    auto row = [&](const char* name, uint64_t v, uint64_t b) {
+      printf(
+        "%-34s %16llu %14.0f\n",
+        name,
+        static_cast<unsigned long long>(v),
+        rate(v, b, seconds));
+    };
+    row(
+      "current_memory_bytes",
+      now.current_memory_bytes,
+      before.current_memory_bytes);
+    row("peak_memory_bytes", now.peak_memory_bytes, before.peak_memory_bytes);
+    row("large_bytes", now.large_bytes, before.large_bytes);
+    row("allocators", now.allocators, before.allocators);
+    row(
+      "allocators_with_pending_messages",
+      now.allocators_with_pending_messages,
+      before.allocators_with_pending_messages);
+
+    for (size_t i = 0; i < NUM_EVENTS; i++)
+      row(event_names[i], now.events[i], before.events[i]);
+
+    printf("\n%-10s %10s %16s %14s\n", "size", "slabs", "bytes", "bytes/s");
+    for (size_t i = 0; i < NUM_SMALL_SIZECLASSES; i++)
+    {
+      if ((now.slabs[i] == 0) && (before.slabs[i] == 0))
+        continue;
+      auto slab_size = segment.slab_sizes[i];
+      printf(
+        "%-10llu %10llu %16llu %14.0f\n",
+        static_cast<unsigned long long>(segment.sizeclass_sizes[i]),
+        static_cast<unsigned long long>(now.slabs[i]),
+        static_cast<unsigned long long>(now.slabs[i] * slab_size),
+        rate(now.slabs[i] * slab_size, before.slabs[i] * slab_size, seconds));
+    }
+    fflush(stdout);
+  }
+} // namespace
+
+int main(int argc, char** argv)
+{
+#if defined(__linux__)
+  if (argc < 2)
+  {
+    fprintf(stderr, "usage: %s <pid> [interval_ms] [iterations]\n", argv[0]);
+    return 1;
+  }
+  uint64_t pid = strtoull(argv[1], nullptr, 10);
+  uint64_t interval_ms = argc > 2 ? strtoull(argv[2], nullptr, 10) : 1000;
+  uint64_t iterations = argc > 3 ? strtoull(argv[3], nullptr, 10) : 0;
+
+  char path[64];
+  shared_stats_path(path, pid);
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+  {
+    fprintf(stderr, "%s: no statistics published at %s\n", argv[0], path);
+    return 1;
+  }
+  void* p =
+    mmap(nullptr, sizeof(SharedStatsSegment), PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (p == MAP_FAILED)
+  {
+    perror("mmap");
+    return 1;
+  }
+
+  auto& segment = *static_cast<const SharedStatsSegment*>(p);
+  if (!segment.is_compatible())
+  {
+    fprintf(stderr, "%s: %s has an unknown layout\n", argv[0], path);
+    return 1;
+  }
+
+  StatsSnapshot before;
+  uint64_t before_ms;
+  if (!segment.read(before, before_ms))
+    return 1;
+
+  for (uint64_t i = 0; (iterations == 0) || (i < iterations); i++)
+  {
+    usleep(static_cast<useconds_t>(interval_ms * 1000));
+
+    // Stop once the process has exited and removed the segment.
+    if (access(path, F_OK) != 0)
+      break;
+
+    StatsSnapshot now;
+    uint64_t now_ms;
+    if (!segment.read(now, now_ms))
+      continue;
+
+    // Rates are over the time between publications, not between reads.
+    double seconds = static_cast<double>(now_ms - before_ms) / 1000;
+    if (seconds <= 0)
+      seconds = static_cast<double>(interval_ms) / 1000;
+    show(segment, now, before, seconds, DefaultPal::time_in_ms() - now_ms);
+
+    before = now;
+    before_ms = now_ms;
+  }
+  return 0;
+#else
+  UNUSED(argc);
+  fprintf(stderr, "%s: shared statistics require Linux\n", argv[0]);
+  return 1;
+#endif
+}